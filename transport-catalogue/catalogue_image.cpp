@@ -0,0 +1,448 @@
+#include "catalogue_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace transport::catalogue {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t SECTION_ALIGNMENT = 8;
+
+// Накопитель секций образа: данные дописываются с выравниванием,
+// а заголовок получает смещения записанных секций
+class ImageBuilder {
+public:
+    ImageBuilder() {
+        buffer_.resize(sizeof(image::Header));
+    }
+
+    template <typename T>
+    image::Section AddSection(const std::vector<T>& items) {
+        Align();
+        image::Section section{buffer_.size(), items.size()};
+        const char* bytes = reinterpret_cast<const char*>(items.data());
+        buffer_.insert(buffer_.end(), bytes, bytes + items.size() * sizeof(T));
+        return section;
+    }
+
+    std::vector<char> Finish(image::Header header) {
+        Align();
+        header.file_size = buffer_.size();
+        std::memcpy(buffer_.data(), &header, sizeof(header));
+        return std::move(buffer_);
+    }
+
+private:
+    void Align() {
+        buffer_.resize((buffer_.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT);
+    }
+
+    std::vector<char> buffer_;
+};
+
+image::StringRef AddString(std::vector<char>& strings, std::string_view str) {
+    image::StringRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(str.size())};
+    strings.insert(strings.end(), str.begin(), str.end());
+    return ref;
+}
+
+}  // namespace
+
+void SaveCatalogueImage(const TransportCatalogue& db, const std::string& path) {
+    const auto& stops = db.GetStops();
+    const auto& buses = db.GetBuses();
+
+    std::unordered_map<const Stop*, uint32_t> stop_ids;
+    stop_ids.reserve(stops.size());
+    for (const Stop& stop : stops) {
+        stop_ids.emplace(&stop, static_cast<uint32_t>(stop_ids.size()));
+    }
+    std::unordered_map<const Bus*, uint32_t> bus_ids;
+    bus_ids.reserve(buses.size());
+    for (const Bus& bus : buses) {
+        bus_ids.emplace(&bus, static_cast<uint32_t>(bus_ids.size()));
+    }
+
+    std::vector<char> strings;
+    std::vector<image::StopRecord> stop_records;
+    std::vector<uint32_t> stop_buses;
+    stop_records.reserve(stops.size());
+    for (const Stop& stop : stops) {
+        image::StopRecord record;
+        record.coords = stop.coords;
+        record.name = AddString(strings, stop.name);
+        record.buses_begin = static_cast<uint32_t>(stop_buses.size());
+        for (const std::string& bus_name : stop.buses) {
+            if (const Bus* bus = db.FindBus(bus_name)) {
+                stop_buses.push_back(bus_ids.at(bus));
+            }
+        }
+        record.buses_count = static_cast<uint32_t>(stop_buses.size()) - record.buses_begin;
+        stop_records.push_back(record);
+    }
+
+    std::vector<image::BusRecord> bus_records;
+    std::vector<uint32_t> bus_stops;
+    bus_records.reserve(buses.size());
+    for (const Bus& bus : buses) {
+        image::BusRecord record;
+        record.name = AddString(strings, bus.name);
+        record.stops_begin = static_cast<uint32_t>(bus_stops.size());
+        record.stops_count = static_cast<uint32_t>(bus.stops.size());
+        record.is_roundtrip = bus.isRoundTrip ? 1 : 0;
+        for (const Stop* stop : bus.stops) {
+            bus_stops.push_back(stop_ids.at(stop));
+        }
+        bus_records.push_back(record);
+    }
+
+    std::vector<image::DistanceRecord> distances;
+    distances.reserve(db.GetDistances().size());
+    for (const auto& [stop_pair, distance] : db.GetDistances()) {
+        distances.push_back({stop_ids.at(stop_pair.first), stop_ids.at(stop_pair.second), distance});
+    }
+    std::sort(distances.begin(), distances.end(), [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+    });
+
+    auto make_order = [&strings](size_t count, auto get_name) {
+        std::vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+            const image::StringRef l = get_name(lhs);
+            const image::StringRef r = get_name(rhs);
+            return std::string_view(strings.data() + l.offset, l.length)
+                 < std::string_view(strings.data() + r.offset, r.length);
+        });
+        return order;
+    };
+    const auto stop_order = make_order(stop_records.size(), [&](uint32_t i) { return stop_records[i].name; });
+    const auto bus_order = make_order(bus_records.size(), [&](uint32_t i) { return bus_records[i].name; });
+
+    image::Header header{};
+    std::memcpy(header.magic, image::MAGIC, sizeof(header.magic));
+    header.version = image::FORMAT_VERSION;
+
+    ImageBuilder builder;
+    header.stops = builder.AddSection(stop_records);
+    header.buses = builder.AddSection(bus_records);
+    header.bus_stops = builder.AddSection(bus_stops);
+    header.stop_buses = builder.AddSection(stop_buses);
+    header.distances = builder.AddSection(distances);
+    header.stop_order = builder.AddSection(stop_order);
+    header.bus_order = builder.AddSection(bus_order);
+    header.strings = builder.AddSection(strings);
+    const std::vector<char> data = builder.Finish(header);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out) {
+        throw ImageError("Failed to write catalogue image "s + path);
+    }
+}
+
+CatalogueImage::CatalogueImage(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw ImageError("Failed to open catalogue image "s + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(image::Header))) {
+        ::close(fd);
+        throw ImageError("Catalogue image "s + path + " is truncated"s);
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw ImageError("Failed to map catalogue image "s + path);
+    }
+    data_ = static_cast<const char*>(mapping);
+
+    try {
+        Validate();
+    } catch (...) {
+        ::munmap(const_cast<char*>(data_), size_);
+        throw;
+    }
+}
+
+CatalogueImage::~CatalogueImage() {
+    ::munmap(const_cast<char*>(data_), size_);
+}
+
+void CatalogueImage::Validate() const {
+    const image::Header& header = GetHeader();
+    if (std::memcmp(header.magic, image::MAGIC, sizeof(header.magic)) != 0) {
+        throw ImageError("Not a catalogue image"s);
+    }
+    if (header.version != image::FORMAT_VERSION) {
+        throw ImageError("Unsupported catalogue image version "s + std::to_string(header.version));
+    }
+    if (header.file_size != size_) {
+        throw ImageError("Catalogue image size mismatch"s);
+    }
+
+    auto check = [this](const image::Section& section, size_t item_size) {
+        if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > size_
+            || section.count > (size_ - section.offset) / item_size) {
+            throw ImageError("Catalogue image section is out of bounds"s);
+        }
+    };
+    check(header.stops, sizeof(image::StopRecord));
+    check(header.buses, sizeof(image::BusRecord));
+    check(header.bus_stops, sizeof(uint32_t));
+    check(header.stop_buses, sizeof(uint32_t));
+    check(header.distances, sizeof(image::DistanceRecord));
+    check(header.stop_order, sizeof(uint32_t));
+    check(header.bus_order, sizeof(uint32_t));
+    check(header.strings, sizeof(char));
+    if (header.stop_order.count != header.stops.count || header.bus_order.count != header.buses.count) {
+        throw ImageError("Catalogue image name index is inconsistent"s);
+    }
+    ValidateRecords();
+}
+
+void CatalogueImage::ValidateRecords() const {
+    // Образ мог быть повреждён или подменён: каждая ссылка и каждый индекс записей
+    // проверяются один раз при открытии, чтобы обращения к образу не выходили за границы
+    const image::Header& header = GetHeader();
+    auto check_range = [](uint64_t begin, uint64_t count, uint64_t size) {
+        if (begin > size || count > size - begin) {
+            throw ImageError("Catalogue image record is out of bounds"s);
+        }
+    };
+    auto check_indices = [this](const image::Section& section, uint64_t limit) {
+        const uint32_t* items = GetSection<uint32_t>(section);
+        for (uint64_t i = 0; i < section.count; ++i) {
+            if (items[i] >= limit) {
+                throw ImageError("Catalogue image index is out of bounds"s);
+            }
+        }
+    };
+
+    const image::StopRecord* stops = GetSection<image::StopRecord>(header.stops);
+    for (uint64_t i = 0; i < header.stops.count; ++i) {
+        check_range(stops[i].name.offset, stops[i].name.length, header.strings.count);
+        check_range(stops[i].buses_begin, stops[i].buses_count, header.stop_buses.count);
+    }
+    const image::BusRecord* buses = GetSection<image::BusRecord>(header.buses);
+    for (uint64_t i = 0; i < header.buses.count; ++i) {
+        check_range(buses[i].name.offset, buses[i].name.length, header.strings.count);
+        check_range(buses[i].stops_begin, buses[i].stops_count, header.bus_stops.count);
+    }
+    check_indices(header.bus_stops, header.stops.count);
+    check_indices(header.stop_buses, header.buses.count);
+    check_indices(header.stop_order, header.stops.count);
+    check_indices(header.bus_order, header.buses.count);
+
+    // Поиск двоичный, поэтому порядок расстояний и имён тоже часть формата
+    const image::DistanceRecord* distances = GetSection<image::DistanceRecord>(header.distances);
+    for (uint64_t i = 0; i < header.distances.count; ++i) {
+        if (distances[i].from >= header.stops.count || distances[i].to >= header.stops.count) {
+            throw ImageError("Catalogue image index is out of bounds"s);
+        }
+        if (i > 0 && std::tie(distances[i - 1].from, distances[i - 1].to)
+                     >= std::tie(distances[i].from, distances[i].to)) {
+            throw ImageError("Catalogue image distances are not sorted"s);
+        }
+    }
+    auto check_order = [this](const image::Section& section, auto get_name) {
+        const uint32_t* order = GetSection<uint32_t>(section);
+        for (uint64_t i = 1; i < section.count; ++i) {
+            if (get_name(order[i]) < get_name(order[i - 1])) {
+                throw ImageError("Catalogue image name index is not sorted"s);
+            }
+        }
+    };
+    check_order(header.stop_order, [this](Index stop) { return GetStopName(stop); });
+    check_order(header.bus_order, [this](Index bus) { return GetBusName(bus); });
+}
+
+const image::Header& CatalogueImage::GetHeader() const {
+    return *reinterpret_cast<const image::Header*>(data_);
+}
+
+size_t CatalogueImage::GetStopCount() const {
+    return GetHeader().stops.count;
+}
+
+size_t CatalogueImage::GetBusCount() const {
+    return GetHeader().buses.count;
+}
+
+std::string_view CatalogueImage::GetString(image::StringRef ref) const {
+    return {GetSection<char>(GetHeader().strings) + ref.offset, ref.length};
+}
+
+const image::StopRecord& CatalogueImage::GetStop(Index stop) const {
+    return GetSection<image::StopRecord>(GetHeader().stops)[stop];
+}
+
+const image::BusRecord& CatalogueImage::GetBus(Index bus) const {
+    return GetSection<image::BusRecord>(GetHeader().buses)[bus];
+}
+
+std::optional<CatalogueImage::Index> CatalogueImage::FindStop(std::string_view name) const {
+    const auto& section = GetHeader().stop_order;
+    const uint32_t* begin = GetSection<uint32_t>(section);
+    const uint32_t* end = begin + section.count;
+    // Как и в справочнике, при совпадении имён побеждает добавленная последней
+    auto it = std::upper_bound(begin, end, name, [this](std::string_view lhs, uint32_t rhs) {
+        return lhs < GetStopName(rhs);
+    });
+    if (it == begin || GetStopName(*(it - 1)) != name) {
+        return std::nullopt;
+    }
+    return *(it - 1);
+}
+
+std::optional<CatalogueImage::Index> CatalogueImage::FindBus(std::string_view name) const {
+    const auto& section = GetHeader().bus_order;
+    const uint32_t* begin = GetSection<uint32_t>(section);
+    const uint32_t* end = begin + section.count;
+    auto it = std::upper_bound(begin, end, name, [this](std::string_view lhs, uint32_t rhs) {
+        return lhs < GetBusName(rhs);
+    });
+    if (it == begin || GetBusName(*(it - 1)) != name) {
+        return std::nullopt;
+    }
+    return *(it - 1);
+}
+
+std::string_view CatalogueImage::GetStopName(Index stop) const {
+    return GetString(GetStop(stop).name);
+}
+
+geo::Coordinates CatalogueImage::GetStopCoords(Index stop) const {
+    return GetStop(stop).coords;
+}
+
+std::vector<std::string_view> CatalogueImage::GetBusesByStop(Index stop) const {
+    const image::StopRecord& record = GetStop(stop);
+    const uint32_t* buses = GetSection<uint32_t>(GetHeader().stop_buses) + record.buses_begin;
+
+    std::vector<std::string_view> result;
+    result.reserve(record.buses_count);
+    for (uint32_t i = 0; i < record.buses_count; ++i) {
+        result.push_back(GetBusName(buses[i]));
+    }
+    return result;
+}
+
+std::string_view CatalogueImage::GetBusName(Index bus) const {
+    return GetString(GetBus(bus).name);
+}
+
+bool CatalogueImage::IsRoundTrip(Index bus) const {
+    return GetBus(bus).is_roundtrip != 0;
+}
+
+std::vector<CatalogueImage::Index> CatalogueImage::GetBusStops(Index bus) const {
+    const image::BusRecord& record = GetBus(bus);
+    const uint32_t* stops = GetSection<uint32_t>(GetHeader().bus_stops) + record.stops_begin;
+    return {stops, stops + record.stops_count};
+}
+
+size_t CatalogueImage::GetRouteStopCount(const image::BusRecord& bus) const {
+    if (bus.is_roundtrip || bus.stops_count == 0) {
+        return bus.stops_count;
+    }
+    return bus.stops_count * 2 - 1;
+}
+
+CatalogueImage::Index CatalogueImage::GetRouteStop(const image::BusRecord& bus, size_t index) const {
+    const uint32_t* stops = GetSection<uint32_t>(GetHeader().bus_stops) + bus.stops_begin;
+    return index < bus.stops_count ? stops[index] : stops[bus.stops_count * 2 - 2 - index];
+}
+
+BusInfo CatalogueImage::GetBusInfo(Index bus) const {
+    const image::BusRecord& record = GetBus(bus);
+    BusInfo info;
+
+    std::vector<Index> unique_stops = GetBusStops(bus);
+    std::sort(unique_stops.begin(), unique_stops.end());
+    unique_stops.erase(std::unique(unique_stops.begin(), unique_stops.end()), unique_stops.end());
+
+    const size_t stop_count = GetRouteStopCount(record);
+    for (size_t i = 1; i < stop_count; ++i) {
+        info.routeLength += GetDistanceBetweenStops(GetRouteStop(record, i - 1), GetRouteStop(record, i));
+    }
+    for (size_t i = 1; i < record.stops_count; ++i) {
+        info.geoDistance += geo::ComputeDistance(GetStopCoords(GetRouteStop(record, i - 1)),
+                                                 GetStopCoords(GetRouteStop(record, i)));
+    }
+    if (!record.is_roundtrip) {
+        info.geoDistance *= 2;
+    }
+
+    info.stopsCount = static_cast<int>(stop_count);
+    info.uniqueStops = static_cast<int>(unique_stops.size());
+    return info;
+}
+
+double CatalogueImage::GetDistanceBetweenStops(Index from, Index to) const {
+    const auto& section = GetHeader().distances;
+    const image::DistanceRecord* begin = GetSection<image::DistanceRecord>(section);
+    const image::DistanceRecord* end = begin + section.count;
+
+    auto find = [begin, end](Index lhs, Index rhs) -> const image::DistanceRecord* {
+        auto it = std::lower_bound(begin, end, std::pair{lhs, rhs}, [](const auto& record, const auto& key) {
+            return std::tie(record.from, record.to) < std::tie(key.first, key.second);
+        });
+        return it != end && it->from == lhs && it->to == rhs ? it : nullptr;
+    };
+
+    if (const auto* record = find(from, to)) {
+        return record->distance;
+    }
+    if (const auto* record = find(to, from)) {
+        return record->distance;
+    }
+    return 0.0;
+}
+
+void CatalogueImage::LoadInto(TransportCatalogue& db) const {
+    CatalogueInput input;
+    input.stops.reserve(GetStopCount());
+    for (Index stop = 0; stop < GetStopCount(); ++stop) {
+        input.stops.push_back({std::string(GetStopName(stop)), GetStopCoords(stop)});
+    }
+
+    const auto& section = GetHeader().distances;
+    const image::DistanceRecord* distances = GetSection<image::DistanceRecord>(section);
+    input.distances.reserve(section.count);
+    for (size_t i = 0; i < section.count; ++i) {
+        input.distances.push_back({std::string(GetStopName(distances[i].from)),
+                                   std::string(GetStopName(distances[i].to)),
+                                   distances[i].distance});
+    }
+
+    input.buses.reserve(GetBusCount());
+    for (Index bus = 0; bus < GetBusCount(); ++bus) {
+        BusInput bus_input{std::string(GetBusName(bus)), {}, IsRoundTrip(bus)};
+        for (Index stop : GetBusStops(bus)) {
+            bus_input.stops.emplace_back(GetStopName(stop));
+        }
+        input.buses.push_back(std::move(bus_input));
+    }
+
+    db.BulkLoad(std::move(input));
+}
+
+}  // namespace transport::catalogue
\ No newline at end of file
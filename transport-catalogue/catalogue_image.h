@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "domain.h"
+#include "geo.h"
+#include "transport_catalogue.h"
+
+namespace transport::catalogue {
+
+// Бинарный образ справочника для отображения в память через mmap.
+// Все ссылки внутри образа — смещения и индексы, а не указатели, поэтому
+// отображённые страницы используются без разбора и могут разделяться
+// несколькими процессами в режиме только для чтения
+namespace image {
+
+inline constexpr char MAGIC[8] = {'T', 'C', 'I', 'M', 'A', 'G', 'E', '\0'};
+inline constexpr uint32_t FORMAT_VERSION = 1;
+
+// Отрезок секции: смещение от начала файла и количество элементов
+struct Section {
+    uint64_t offset = 0;
+    uint64_t count = 0;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t reserved = 0;
+    uint64_t file_size = 0;
+    Section stops;        // StopRecord[]
+    Section buses;        // BusRecord[]
+    Section bus_stops;    // uint32_t[] индексы остановок маршрутов
+    Section stop_buses;   // uint32_t[] индексы маршрутов остановок, по имени маршрута
+    Section distances;    // DistanceRecord[], упорядочены по (from, to)
+    Section stop_order;   // uint32_t[] индексы остановок, упорядоченные по имени
+    Section bus_order;    // uint32_t[] индексы маршрутов, упорядоченные по имени
+    Section strings;      // char[] имена
+};
+
+struct StringRef {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+struct StopRecord {
+    geo::Coordinates coords;
+    StringRef name;
+    uint32_t buses_begin = 0;
+    uint32_t buses_count = 0;
+};
+
+struct BusRecord {
+    StringRef name;
+    uint32_t stops_begin = 0;
+    uint32_t stops_count = 0;
+    uint32_t is_roundtrip = 0;
+    uint32_t reserved = 0;
+};
+
+struct DistanceRecord {
+    uint32_t from = 0;
+    uint32_t to = 0;
+    double distance = 0.0;
+};
+
+}  // namespace image
+
+class ImageError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+// Записывает образ справочника в файл
+void SaveCatalogueImage(const TransportCatalogue& db, const std::string& path);
+
+// Отображённый в память образ справочника. Остановки и маршруты адресуются индексами,
+// имена возвращаются как string_view на отображённые страницы
+class CatalogueImage {
+public:
+    using Index = uint32_t;
+
+    explicit CatalogueImage(const std::string& path);
+    CatalogueImage(const CatalogueImage&) = delete;
+    CatalogueImage& operator=(const CatalogueImage&) = delete;
+    ~CatalogueImage();
+
+    size_t GetStopCount() const;
+    size_t GetBusCount() const;
+
+    std::optional<Index> FindStop(std::string_view name) const;
+    std::optional<Index> FindBus(std::string_view name) const;
+
+    std::string_view GetStopName(Index stop) const;
+    geo::Coordinates GetStopCoords(Index stop) const;
+    // Названия маршрутов, проходящих через остановку, в алфавитном порядке
+    std::vector<std::string_view> GetBusesByStop(Index stop) const;
+
+    std::string_view GetBusName(Index bus) const;
+    bool IsRoundTrip(Index bus) const;
+    // Остановки в том виде, в каком они хранятся в Bus::stops
+    std::vector<Index> GetBusStops(Index bus) const;
+    BusInfo GetBusInfo(Index bus) const;
+
+    double GetDistanceBetweenStops(Index from, Index to) const;
+
+    // Наполняет обычный справочник данными образа для подсистем,
+    // работающих с указателями на Stop и Bus (маршрутизатор, отрисовка карты)
+    void LoadInto(TransportCatalogue& db) const;
+
+private:
+    template <typename T>
+    const T* GetSection(const image::Section& section) const {
+        return reinterpret_cast<const T*>(data_ + section.offset);
+    }
+
+    std::string_view GetString(image::StringRef ref) const;
+    const image::Header& GetHeader() const;
+    const image::StopRecord& GetStop(Index stop) const;
+    const image::BusRecord& GetBus(Index bus) const;
+    Index GetRouteStop(const image::BusRecord& bus, size_t index) const;
+    size_t GetRouteStopCount(const image::BusRecord& bus) const;
+    void Validate() const;
+    void ValidateRecords() const;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace transport::catalogue
\ No newline at end of file
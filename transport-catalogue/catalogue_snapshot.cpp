@@ -0,0 +1,97 @@
+#include "catalogue_snapshot.h"
+
+#include <functional>
+#include <thread>
+#include <utility>
+
+namespace transport::catalogue {
+
+CatalogueSnapshots::Snapshot::Snapshot(const Snapshot& other)
+    : version_(other.version_) {
+    if (version_) {
+        version_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+CatalogueSnapshots::Snapshot::Snapshot(Snapshot&& other) noexcept
+    : version_(std::exchange(other.version_, nullptr)) {
+}
+
+CatalogueSnapshots::Snapshot& CatalogueSnapshots::Snapshot::operator=(Snapshot other) noexcept {
+    std::swap(version_, other.version_);
+    return *this;
+}
+
+CatalogueSnapshots::Snapshot::~Snapshot() {
+    if (version_) {
+        Release(version_);
+    }
+}
+
+CatalogueSnapshots::CatalogueSnapshots(std::unique_ptr<TransportCatalogue> initial)
+    : current_(new Version(std::move(initial), 1)) {
+}
+
+CatalogueSnapshots::~CatalogueSnapshots() {
+    Release(current_.load());
+}
+
+CatalogueSnapshots::Snapshot CatalogueSnapshots::Acquire() const {
+    // Начинаем поиск свободного слота с позиции, зависящей от потока,
+    // чтобы параллельные читатели не конкурировали за один и тот же слот
+    const size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id()) % READER_SLOTS;
+
+    while (true) {
+        for (size_t i = 0; i < READER_SLOTS; ++i) {
+            ReaderSlot& slot = slots_[(start + i) % READER_SLOTS];
+            uint64_t expected = FREE_SLOT;
+            if (!slot.epoch.compare_exchange_strong(expected, epoch_.load())) {
+                continue;
+            }
+
+            // Пока слот занят, писатель не отпустит версию, снятую с current_,
+            // поэтому счётчик ссылок увеличивается у ещё живой версии
+            Version* version = current_.load();
+            version->refs.fetch_add(1, std::memory_order_relaxed);
+            slot.epoch.store(FREE_SLOT, std::memory_order_release);
+            return Snapshot(version);
+        }
+        std::this_thread::yield();
+    }
+}
+
+uint64_t CatalogueSnapshots::Publish(std::unique_ptr<TransportCatalogue> next) {
+    std::lock_guard guard(writer_mutex_);
+
+    Version* previous = current_.load();
+    Version* version = new Version(std::move(next), previous->number + 1);
+    current_.store(version);
+
+    WaitForReaders(epoch_.fetch_add(1) + 1);
+    Release(previous);
+    return version->number;
+}
+
+uint64_t CatalogueSnapshots::GetVersion() const {
+    return current_.load()->number;
+}
+
+void CatalogueSnapshots::Release(Version* version) {
+    if (version->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete version;
+    }
+}
+
+void CatalogueSnapshots::WaitForReaders(uint64_t retire_epoch) const {
+    // Читатели, закрепившиеся до смены эпохи, могли увидеть старую версию.
+    // Они держат слот только на время увеличения счётчика ссылок
+    for (const ReaderSlot& slot : slots_) {
+        uint64_t epoch = slot.epoch.load();
+        while (epoch != FREE_SLOT && epoch < retire_epoch) {
+            std::this_thread::yield();
+            epoch = slot.epoch.load();
+        }
+    }
+}
+
+}  // namespace transport::catalogue
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "transport_catalogue.h"
+
+namespace transport::catalogue {
+
+// Хранилище неизменяемых версий справочника для чтения во время обновлений.
+// Читатели закрепляют текущую версию без блокировок: короткая эпоха защищает
+// переход от атомарного указателя к счётчику ссылок версии. Писатель готовит
+// следующую версию целиком и публикует её атомарной заменой указателя.
+// Старая версия удаляется, когда её не держит ни один снимок
+class CatalogueSnapshots {
+    struct Version {
+        Version(std::unique_ptr<const TransportCatalogue> catalogue, uint64_t number)
+            : catalogue(std::move(catalogue)), number(number) {}
+
+        std::unique_ptr<const TransportCatalogue> catalogue;
+        uint64_t number = 0;
+        std::atomic<size_t> refs{1};
+    };
+
+public:
+    // Закреплённая версия справочника. Указатели на Stop и Bus, полученные
+    // через снимок, действительны, пока жив он сам или его копия
+    class Snapshot {
+    public:
+        Snapshot() = default;
+        Snapshot(const Snapshot& other);
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot other) noexcept;
+        ~Snapshot();
+
+        const TransportCatalogue& operator*() const {
+            return *version_->catalogue;
+        }
+        const TransportCatalogue* operator->() const {
+            return version_->catalogue.get();
+        }
+        uint64_t GetVersion() const {
+            return version_ ? version_->number : 0;
+        }
+        explicit operator bool() const {
+            return version_ != nullptr;
+        }
+
+    private:
+        explicit Snapshot(Version* version)
+            : version_(version) {}
+
+        Version* version_ = nullptr;
+
+        friend class CatalogueSnapshots;
+    };
+
+    explicit CatalogueSnapshots(std::unique_ptr<TransportCatalogue> initial = std::make_unique<TransportCatalogue>());
+    CatalogueSnapshots(const CatalogueSnapshots&) = delete;
+    CatalogueSnapshots& operator=(const CatalogueSnapshots&) = delete;
+    ~CatalogueSnapshots();
+
+    // Закрепляет текущую версию. Не берёт блокировок
+    Snapshot Acquire() const;
+
+    // Публикует следующую версию и возвращает её номер.
+    // Писатели сериализуются между собой, читатели не ждут
+    uint64_t Publish(std::unique_ptr<TransportCatalogue> next);
+
+    uint64_t GetVersion() const;
+
+private:
+    static constexpr size_t READER_SLOTS = 64;
+    static constexpr uint64_t FREE_SLOT = 0;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{FREE_SLOT};
+    };
+
+    static void Release(Version* version);
+    void WaitForReaders(uint64_t retire_epoch) const;
+
+    mutable std::array<ReaderSlot, READER_SLOTS> slots_;
+    std::atomic<Version*> current_;
+    std::atomic<uint64_t> epoch_{1};
+    std::mutex writer_mutex_;
+};
+
+}  // namespace transport::catalogue
\ No newline at end of file
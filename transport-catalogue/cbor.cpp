@@ -0,0 +1,531 @@
+#include "cbor.h"
+
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <sstream>
+
+namespace cbor {
+
+namespace {
+
+// Старшие три бита начального байта
+enum MajorType : uint8_t {
+    UNSIGNED = 0,
+    NEGATIVE = 1,
+    BYTES = 2,
+    TEXT = 3,
+    ARRAY = 4,
+    MAP = 5,
+    TAG = 6,
+    SIMPLE = 7,
+};
+
+// Младшие пять бит: аргумент в следующих 1, 2, 4 или 8 байтах либо неопределённая длина
+constexpr uint8_t ARGUMENT_1 = 24;
+constexpr uint8_t ARGUMENT_2 = 25;
+constexpr uint8_t ARGUMENT_4 = 26;
+constexpr uint8_t ARGUMENT_8 = 27;
+constexpr uint8_t INDEFINITE = 31;
+
+constexpr uint8_t FALSE_VALUE = 20;
+constexpr uint8_t TRUE_VALUE = 21;
+constexpr uint8_t NULL_VALUE = 22;
+constexpr uint8_t UNDEFINED_VALUE = 23;
+
+constexpr uint8_t BREAK = 0xff;
+
+// Ограничение вложенности, чтобы испорченный ввод не переполнил стек рекурсии
+constexpr int MAX_DEPTH = 1024;
+
+double DecodeHalf(uint16_t bits) {
+    const int exponent = (bits >> 10) & 0x1f;
+    const int mantissa = bits & 0x3ff;
+    double value;
+    if (exponent == 0) {
+        value = std::ldexp(mantissa, -24);
+    } else if (exponent == 0x1f) {
+        value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+    } else {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    }
+    return (bits & 0x8000) ? -value : value;
+}
+
+// Запись числа в половинной точности, если она его не искажает
+std::optional<uint16_t> EncodeHalf(double value) {
+    if (std::isnan(value)) {
+        return 0x7e00;
+    }
+    const uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+    const double magnitude = std::fabs(value);
+    if (magnitude == 0 || std::isinf(magnitude)) {
+        return static_cast<uint16_t>(sign | (magnitude == 0 ? 0 : 0x7c00));
+    }
+    int exponent;
+    std::frexp(magnitude, &exponent);
+    // Нормализованные числа половинной точности имеют порядок от -14 до 15,
+    // меньшие представимы денормализованными с шагом 2^-24
+    if (exponent > 16 || exponent < -23) {
+        return std::nullopt;
+    }
+    const int step = std::max(exponent - 11, -24);
+    const double mantissa = std::ldexp(magnitude, -step);
+    if (mantissa != std::trunc(mantissa)) {
+        return std::nullopt;
+    }
+    uint16_t bits;
+    if (step == -24 && mantissa < 1024) {
+        bits = static_cast<uint16_t>(mantissa);
+    } else {
+        bits = static_cast<uint16_t>((step + 25) << 10 | (static_cast<int>(mantissa) - 1024));
+    }
+    return static_cast<uint16_t>(sign | bits);
+}
+
+// Чтение заголовков и строк без разбора значений
+class Scanner {
+public:
+    explicit Scanner(std::string_view input)
+        : pos_(reinterpret_cast<const uint8_t*>(input.data()))
+        , end_(pos_ + input.size()) {}
+
+    // Пропускает очередной элемент целиком, не сообщая о его содержимом
+    void SkipItem(int depth) {
+        if (depth > MAX_DEPTH) {
+            throw ParsingError("Nesting is too deep");
+        }
+        const uint8_t initial = ReadByte();
+        const uint8_t info = initial & 0x1f;
+        switch (initial >> 5) {
+            case UNSIGNED:
+            case NEGATIVE:
+                ReadArgument(info);
+                break;
+            case BYTES:
+            case TEXT:
+                if (info == INDEFINITE) {
+                    while (!AtBreak()) {
+                        SkipItem(depth + 1);
+                    }
+                } else {
+                    ReadChunk(ReadArgument(info));
+                }
+                break;
+            case ARRAY:
+            case MAP: {
+                // В словаре на каждую пару приходится два элемента
+                const uint64_t per_entry = initial >> 5 == MAP ? 2 : 1;
+                if (info == INDEFINITE) {
+                    while (!AtBreak()) {
+                        for (uint64_t i = 0; i < per_entry; ++i) {
+                            SkipItem(depth + 1);
+                        }
+                    }
+                } else {
+                    for (uint64_t count = ReadArgument(info); count > 0; --count) {
+                        for (uint64_t i = 0; i < per_entry; ++i) {
+                            SkipItem(depth + 1);
+                        }
+                    }
+                }
+                break;
+            }
+            case TAG:
+                ReadArgument(info);
+                SkipItem(depth + 1);
+                break;
+            default:
+                if (info >= ARGUMENT_1) {
+                    ReadArgument(info);
+                }
+                break;
+        }
+    }
+
+    std::optional<std::string_view> FindMember(std::string_view key) {
+        const uint8_t initial = ReadByte();
+        if (initial >> 5 != MAP) {
+            throw ParsingError("Root is not a dictionary");
+        }
+        const uint8_t info = initial & 0x1f;
+        uint64_t count = info == INDEFINITE ? 0 : ReadArgument(info);
+        while (info == INDEFINITE ? !AtBreak() : count-- > 0) {
+            const uint8_t key_initial = ReadByte();
+            if (key_initial >> 5 != TEXT) {
+                throw ParsingError("Dictionary key must be a text string");
+            }
+            const bool found = ReadText(key_initial & 0x1f) == key;
+            const uint8_t* value = pos_;
+            SkipItem(1);
+            if (found) {
+                return std::string_view(reinterpret_cast<const char*>(value), pos_ - value);
+            }
+        }
+        return std::nullopt;
+    }
+
+protected:
+    uint8_t ReadByte() {
+        if (pos_ == end_) {
+            throw ParsingError("Unexpected end of input");
+        }
+        return *pos_++;
+    }
+
+    uint64_t ReadBigEndian(int bytes) {
+        if (end_ - pos_ < bytes) {
+            throw ParsingError("Unexpected end of input");
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value = (value << 8) | *pos_++;
+        }
+        return value;
+    }
+
+    uint64_t ReadArgument(uint8_t info) {
+        if (info < ARGUMENT_1) {
+            return info;
+        }
+        switch (info) {
+            case ARGUMENT_1:
+                return ReadBigEndian(1);
+            case ARGUMENT_2:
+                return ReadBigEndian(2);
+            case ARGUMENT_4:
+                return ReadBigEndian(4);
+            case ARGUMENT_8:
+                return ReadBigEndian(8);
+            default:
+                throw ParsingError("Invalid additional information");
+        }
+    }
+
+    bool AtBreak() {
+        if (pos_ == end_) {
+            throw ParsingError("Unexpected end of input");
+        }
+        if (*pos_ == BREAK) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    std::string_view ReadChunk(uint64_t length) {
+        if (static_cast<uint64_t>(end_ - pos_) < length) {
+            throw ParsingError("Unexpected end of input");
+        }
+        const std::string_view chunk(reinterpret_cast<const char*>(pos_), length);
+        pos_ += length;
+        return chunk;
+    }
+
+    // Строка неопределённой длины состоит из частей определённой длины того же типа
+    std::string_view ReadText(uint8_t info) {
+        if (info != INDEFINITE) {
+            return ReadChunk(ReadArgument(info));
+        }
+        text_.clear();
+        while (!AtBreak()) {
+            const uint8_t initial = ReadByte();
+            if (initial >> 5 != TEXT || (initial & 0x1f) == INDEFINITE) {
+                throw ParsingError("Invalid chunk of text string");
+            }
+            text_.append(ReadChunk(ReadArgument(initial & 0x1f)));
+        }
+        return text_;
+    }
+
+    const uint8_t* pos_;
+    const uint8_t* end_;
+    // Склеенные части строки неопределённой длины
+    std::string text_;
+};
+
+class Parser : private Scanner {
+public:
+    Parser(std::string_view input, json::SaxHandler& handler)
+        : Scanner(input)
+        , handler_(handler) {}
+
+    void ParseDocument() {
+        ParseItem(0);
+        if (pos_ != end_) {
+            throw ParsingError("Unexpected data after item");
+        }
+    }
+
+private:
+    void ParseNumber(bool negative, uint64_t argument) {
+        // Целые вне диапазона int, как и в тексте JSON, становятся вещественными
+        if (!negative && argument <= static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+            handler_.Int(static_cast<int>(argument));
+        } else if (negative && argument <= static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+            handler_.Int(-1 - static_cast<int>(argument));
+        } else {
+            const double value = static_cast<double>(argument);
+            handler_.Double(negative ? -1.0 - value : value);
+        }
+    }
+
+    void ParseSimple(uint8_t info) {
+        switch (info) {
+            case FALSE_VALUE:
+                handler_.Bool(false);
+                return;
+            case TRUE_VALUE:
+                handler_.Bool(true);
+                return;
+            case NULL_VALUE:
+            case UNDEFINED_VALUE:
+                handler_.Null();
+                return;
+            case ARGUMENT_2:
+                handler_.Double(DecodeHalf(static_cast<uint16_t>(ReadBigEndian(2))));
+                return;
+            case ARGUMENT_4: {
+                const uint32_t bits = static_cast<uint32_t>(ReadBigEndian(4));
+                float value;
+                std::memcpy(&value, &bits, sizeof(value));
+                handler_.Double(value);
+                return;
+            }
+            case ARGUMENT_8: {
+                const uint64_t bits = ReadBigEndian(8);
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                handler_.Double(value);
+                return;
+            }
+            default:
+                throw ParsingError("Unsupported simple value " + std::to_string(info));
+        }
+    }
+
+    void ParseArray(uint8_t info, int depth) {
+        handler_.StartArray();
+        if (info == INDEFINITE) {
+            while (!AtBreak()) {
+                ParseItem(depth + 1);
+            }
+        } else {
+            for (uint64_t count = ReadArgument(info); count > 0; --count) {
+                ParseItem(depth + 1);
+            }
+        }
+        handler_.EndArray();
+    }
+
+    void ParseKey() {
+        const uint8_t initial = ReadByte();
+        if (initial >> 5 != TEXT) {
+            throw ParsingError("Dictionary key must be a text string");
+        }
+        handler_.Key(ReadText(initial & 0x1f));
+    }
+
+    void ParseMap(uint8_t info, int depth) {
+        handler_.StartDict();
+        if (info == INDEFINITE) {
+            while (!AtBreak()) {
+                ParseKey();
+                ParseItem(depth + 1);
+            }
+        } else {
+            for (uint64_t count = ReadArgument(info); count > 0; --count) {
+                ParseKey();
+                ParseItem(depth + 1);
+            }
+        }
+        handler_.EndDict();
+    }
+
+    void ParseItem(int depth) {
+        if (depth > MAX_DEPTH) {
+            throw ParsingError("Nesting is too deep");
+        }
+        const uint8_t initial = ReadByte();
+        const uint8_t info = initial & 0x1f;
+        switch (initial >> 5) {
+            case UNSIGNED:
+                ParseNumber(false, ReadArgument(info));
+                break;
+            case NEGATIVE:
+                ParseNumber(true, ReadArgument(info));
+                break;
+            case BYTES:
+                throw ParsingError("Byte strings are not supported");
+            case TEXT:
+                handler_.String(ReadText(info));
+                break;
+            case ARRAY:
+                ParseArray(info, depth);
+                break;
+            case MAP:
+                ParseMap(info, depth);
+                break;
+            case TAG:
+                // Смысл тега не интерпретируется, берётся само значение
+                ReadArgument(info);
+                ParseItem(depth + 1);
+                break;
+            default:
+                ParseSimple(info);
+                break;
+        }
+    }
+
+    json::SaxHandler& handler_;
+};
+
+}  // namespace
+
+void Parse(std::string_view input, json::SaxHandler& handler) {
+    Parser(input, handler).ParseDocument();
+}
+
+std::optional<std::string_view> FindMember(std::string_view input, std::string_view key) {
+    return Scanner(input).FindMember(key);
+}
+
+json::Node Load(std::string_view input) {
+    json::DomBuilder builder;
+    cbor::Parse(input, builder);
+    return builder.ExtractRoot();
+}
+
+std::string ToJson(std::string_view input) {
+    std::ostringstream output;
+    {
+        json::Writer writer(output, {true, json::SHORTEST_PRECISION});
+        json::SaxPrinter printer(writer);
+        cbor::Parse(input, printer);
+    }
+    return output.str();
+}
+
+Writer::Writer(std::ostream& output)
+    : output_(output) {
+    buffer_.reserve(BLOCK_SIZE + BLOCK_SIZE / 2);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Null() {
+    buffer_.push_back(static_cast<char>(SIMPLE << 5 | NULL_VALUE));
+    FlushIfFull();
+}
+
+void Writer::Bool(bool value) {
+    buffer_.push_back(static_cast<char>(SIMPLE << 5 | (value ? TRUE_VALUE : FALSE_VALUE)));
+    FlushIfFull();
+}
+
+void Writer::Int(int value) {
+    if (value >= 0) {
+        WriteHead(UNSIGNED, static_cast<uint64_t>(value));
+    } else {
+        // Отрицательное n хранится как -1 - n
+        WriteHead(NEGATIVE, static_cast<uint64_t>(-1 - static_cast<int64_t>(value)));
+    }
+    FlushIfFull();
+}
+
+void Writer::Double(double value) {
+    if (const auto half = EncodeHalf(value)) {
+        buffer_.push_back(static_cast<char>(SIMPLE << 5 | ARGUMENT_2));
+        WriteBigEndian(*half, 2);
+    } else if (const float narrow = static_cast<float>(value); static_cast<double>(narrow) == value) {
+        uint32_t bits;
+        std::memcpy(&bits, &narrow, sizeof(bits));
+        buffer_.push_back(static_cast<char>(SIMPLE << 5 | ARGUMENT_4));
+        WriteBigEndian(bits, 4);
+    } else {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        buffer_.push_back(static_cast<char>(SIMPLE << 5 | ARGUMENT_8));
+        WriteBigEndian(bits, 8);
+    }
+    FlushIfFull();
+}
+
+void Writer::String(std::string_view value) {
+    WriteHead(TEXT, value.size());
+    buffer_.append(value);
+    FlushIfFull();
+}
+
+void Writer::StartDict() {
+    buffer_.push_back(static_cast<char>(MAP << 5 | INDEFINITE));
+}
+
+void Writer::Key(std::string_view key) {
+    String(key);
+}
+
+void Writer::EndDict() {
+    buffer_.push_back(static_cast<char>(BREAK));
+    FlushIfFull();
+}
+
+void Writer::StartArray() {
+    buffer_.push_back(static_cast<char>(ARRAY << 5 | INDEFINITE));
+}
+
+void Writer::EndArray() {
+    buffer_.push_back(static_cast<char>(BREAK));
+    FlushIfFull();
+}
+
+void Writer::Flush() {
+    if (!buffer_.empty()) {
+        output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+void Writer::WriteHead(uint8_t major, uint64_t argument) {
+    const auto initial = [major](uint8_t info) {
+        return static_cast<char>(major << 5 | info);
+    };
+    if (argument < ARGUMENT_1) {
+        buffer_.push_back(initial(static_cast<uint8_t>(argument)));
+    } else if (argument <= 0xff) {
+        buffer_.push_back(initial(ARGUMENT_1));
+        WriteBigEndian(argument, 1);
+    } else if (argument <= 0xffff) {
+        buffer_.push_back(initial(ARGUMENT_2));
+        WriteBigEndian(argument, 2);
+    } else if (argument <= 0xffffffff) {
+        buffer_.push_back(initial(ARGUMENT_4));
+        WriteBigEndian(argument, 4);
+    } else {
+        buffer_.push_back(initial(ARGUMENT_8));
+        WriteBigEndian(argument, 8);
+    }
+}
+
+void Writer::WriteBigEndian(uint64_t value, int bytes) {
+    for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8) {
+        buffer_.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+void Writer::FlushIfFull() {
+    if (buffer_.size() >= BLOCK_SIZE) {
+        Flush();
+    }
+}
+
+void Print(const json::Node& node, std::ostream& output) {
+    Writer writer(output);
+    json::Emit(node, writer);
+}
+
+}  // namespace cbor
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "json.h"
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Двоичное представление той же модели данных в формате CBOR (RFC 8949).
+// Значения разбираются в те же события SaxHandler, что и текст JSON, поэтому
+// DomBuilder и потоковый разбор JSONReader работают с ним без изменений
+namespace cbor {
+
+class ParsingError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+// Разбирает один элемент данных, занимающий весь буфер. Поддерживаются целые,
+// текстовые строки, массивы и словари с текстовыми ключами, в том числе
+// неопределённой длины, простые значения и числа с плавающей точкой всех размеров.
+// Теги пропускаются, байтовые строки не имеют аналога в json::Node и отвергаются
+void Parse(std::string_view input, json::SaxHandler& handler);
+
+json::Node Load(std::string_view input);
+
+// Перекодирует элемент данных в компактный текст JSON без построения дерева.
+// Числа пишутся кратчайшей точной записью, поэтому значения не меняются
+std::string ToJson(std::string_view input);
+
+// Закодированное значение ключа key корневого словаря input, если ключ есть.
+// Остальные значения пропускаются по заголовкам без разбора
+std::optional<std::string_view> FindMember(std::string_view input, std::string_view key);
+
+// Кодирует события в CBOR. Длина контейнеров заранее неизвестна, поэтому они
+// записываются в форме неопределённой длины с завершающим байтом break.
+// Вещественные числа пишутся в самой короткой из записей в 2, 4 и 8 байт,
+// которая хранит значение точно, поэтому тип и значение узла не меняются
+class Writer final : public json::SaxHandler {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    explicit Writer(std::ostream& output);
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer();
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+
+    void Flush();
+
+private:
+    // Заголовок элемента: старший тип и аргумент в кратчайшей записи
+    void WriteHead(uint8_t major, uint64_t argument);
+    void WriteBigEndian(uint64_t value, int bytes);
+    void FlushIfFull();
+
+    std::ostream& output_;
+    std::string buffer_;
+};
+
+void Print(const json::Node& node, std::ostream& output);
+
+}  // namespace cbor
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <set>
@@ -7,21 +9,114 @@
 
 namespace transport::catalogue {
 
+struct Bus;
+
 // Структура, представляющая остановку
 struct Stop{
     std::string name;
     geo::Coordinates coords;
     std::set<std::string> buses;
+    // Удалённая дельтой остановка остаётся в памяти, чтобы не висли указатели на неё
+    bool isRemoved = false;
+};
+
+// Диапазон остановок полного маршрута автобуса.
+// Для некольцевого маршрута A-B-C хранится только прямое направление,
+// а диапазон виртуально выдаёт A, B, C, B, A
+class RouteStops {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const Stop*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = value_type;
+
+        Iterator(const Bus* bus, size_t index)
+            : bus_(bus), index_(index) {}
+
+        reference operator*() const;
+
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator prev = *this;
+            ++index_;
+            return prev;
+        }
+
+        bool operator==(const Iterator& rhs) const {
+            return index_ == rhs.index_;
+        }
+        bool operator!=(const Iterator& rhs) const {
+            return !(*this == rhs);
+        }
+
+    private:
+        const Bus* bus_;
+        size_t index_;
+    };
+
+    explicit RouteStops(const Bus& bus)
+        : bus_(&bus) {}
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const;
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    const Bus* bus_;
 };
 
 // Структура, представляющая автобусный маршрут
 struct Bus{
     std::string name;
+    // Для некольцевого маршрута — только остановки прямого направления,
+    // для кольцевого — весь маршрут, последняя остановка совпадает с первой
     std::vector<Stop*> stops;
     bool isRoundTrip = false;
-    size_t originalStopCount = 0;
+    bool isRemoved = false;
+
+    // Количество остановок на полном маршруте с учётом обратного направления
+    size_t GetRouteStopCount() const {
+        if (isRoundTrip || stops.empty()) {
+            return stops.size();
+        }
+        return stops.size() * 2 - 1;
+    }
+
+    // Остановка полного маршрута по её порядковому номеру
+    const Stop* GetRouteStop(size_t index) const {
+        return index < stops.size() ? stops[index] : stops[stops.size() * 2 - 2 - index];
+    }
+
+    RouteStops GetRouteStops() const {
+        return RouteStops(*this);
+    }
 };
 
+inline RouteStops::Iterator::reference RouteStops::Iterator::operator*() const {
+    return bus_->GetRouteStop(index_);
+}
+
+inline RouteStops::Iterator RouteStops::begin() const {
+    return Iterator(bus_, 0);
+}
+
+inline RouteStops::Iterator RouteStops::end() const {
+    return Iterator(bus_, bus_->GetRouteStopCount());
+}
+
+inline size_t RouteStops::size() const {
+    return bus_->GetRouteStopCount();
+}
+
 // Структура для хранения информации о маршруте
 struct BusInfo{
     int stopsCount = 0;
@@ -30,4 +125,25 @@ struct BusInfo{
     double geoDistance = 0.0;
 };
 
+// Сводные показатели по всей сети
+struct NetworkStats{
+    struct StopLoad{
+        const Stop* stop = nullptr;
+        size_t busCount = 0;
+    };
+    struct BusStats{
+        const Bus* bus = nullptr;
+        BusInfo info;
+    };
+
+    size_t stopCount = 0;
+    size_t servedStopCount = 0;  // остановки, через которые проходит хотя бы один маршрут
+    size_t busCount = 0;
+    double totalRouteLength = 0.0;
+    double totalGeoDistance = 0.0;
+    std::vector<StopLoad> busiestStops;     // по убыванию числа маршрутов
+    std::vector<BusStats> mostCurvedBuses;  // по убыванию извилистости
+    std::vector<BusStats> buses;            // все маршруты в порядке названий
+};
+
 }  // namespace transport::catalogue
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "memory_usage.h"
 #include "ranges.h"
 
 #include <cstdlib>
@@ -26,12 +27,14 @@ private:
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+    VertexId AddVertex();
     EdgeId AddEdge(const Edge<Weight>& edge);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    void CollectMemoryUsage(memory::MemoryReport& report, const std::string& prefix) const;
 
 private:
     std::vector<Edge<Weight>> edges_;
@@ -43,6 +46,12 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     edges_.push_back(edge);
@@ -71,4 +80,14 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::CollectMemoryUsage(memory::MemoryReport& report, const std::string& prefix) const {
+    report.push_back({prefix + "edges", memory::ContainerUsage(edges_)});
+    memory::MemoryUsage incidence = memory::ContainerUsage(incidence_lists_);
+    for (const auto& list : incidence_lists_) {
+        incidence += memory::ContainerUsage(list);
+    }
+    report.push_back({prefix + "incidence_lists", incidence});
+}
 }  // namespace graph
\ No newline at end of file
@@ -1,6 +1,18 @@
 #include "json.h"
 
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <iterator>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace json {
 
@@ -10,6 +22,62 @@ using namespace std::literals;
 Node LoadNode(std::istream& input);
 Node LoadString(std::istream& input);
 
+// Первый из символов Specials в [pos, end) или end. Строки в JSON длинные и почти без
+// спецсимволов, поэтому блоки по 32 (AVX2) или 16 (SSE2) байт проверяются разом,
+// а посимвольно только хвост
+template <char... Specials>
+const char* FindFirstOf(const char* pos, const char* end) {
+#if defined(__AVX2__)
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        __m256i matches = _mm256_setzero_si256();
+        ((matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(Specials)))), ...);
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(matches));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        __m128i matches = _mm_setzero_si128();
+        ((matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(Specials)))), ...);
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (pos != end && ((*pos != Specials) && ...)) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Символы, на которых останавливается разбор строки
+const char* FindStringSpecial(const char* pos, const char* end) {
+    return FindFirstOf<'"', '\\', '\n', '\r'>(pos, end);
+}
+
+// Преобразует проверенную запись числа без выделения памяти и исключений на
+// успешном пути. Целое, не помещающееся в int, разбирается как double
+Node ConvertNumber(std::string_view text, bool is_int) {
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+    if (is_int) {
+        int value = 0;
+        if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc{} && ptr == end) {
+            return value;
+        }
+    }
+    double value = 0.0;
+    if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc{} && ptr == end) {
+        return value;
+    }
+    throw ParsingError("Failed to convert "s + std::string(text) + " to number"s);
+}
+
 std::string LoadLiteral(std::istream& input) {
     std::string s;
     while (std::isalpha(input.peek())) {
@@ -174,20 +242,7 @@ Node LoadNumber(std::istream& input) {
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
-            }
-        }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-    }
+    return ConvertNumber(parsed_num, is_int);
 }
 
 Node LoadNode(std::istream& input) {
@@ -222,64 +277,571 @@ Node LoadNode(std::istream& input) {
     }
 }
 
-struct PrintContext {
-    std::ostream& out;
-    int indent_step = 4;
-    int indent = 0;
+// Лексический разбор непрерывного буфера: символы читаются сдвигом указателя,
+// без обращений к потоку. Грамматика и сообщения об ошибках те же, что у потокового разбора
+class BufferScanner {
+public:
+    explicit BufferScanner(std::string_view input)
+        : pos_(input.data()), end_(input.data() + input.size()) {
+    }
+
+    const char* GetPosition() const {
+        return pos_;
+    }
+
+protected:
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    static bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool IsAlpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
 
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
+    // Аналог input >> c: пропускает пробельные символы и берёт следующий
+    bool NextNonSpace(char& c) {
+        while (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+        }
+        if (pos_ == end_) {
+            return false;
         }
+        c = *pos_++;
+        return true;
     }
 
-    PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+    // Аналог putback для только что прочитанного символа
+    void PutBack() {
+        --pos_;
     }
-};
 
-void PrintNode(const Node& value, const PrintContext& ctx);
+    const char* GetEnd() const {
+        return end_;
+    }
 
-template <typename Value>
-void PrintValue(const Value& value, const PrintContext& ctx) {
-    ctx.out << value;
-}
+    void SetPosition(const char* pos) {
+        pos_ = pos;
+    }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
-            case '\r':
-                out << "\\r"sv;
+    int Peek() const {
+        return pos_ != end_ ? static_cast<unsigned char>(*pos_) : std::char_traits<char>::eof();
+    }
+
+    std::string_view LoadLiteral() {
+        const char* begin = pos_;
+        while (pos_ != end_ && IsAlpha(*pos_)) {
+            ++pos_;
+        }
+        return {begin, static_cast<size_t>(pos_ - begin)};
+    }
+
+    // Пропускает значение по балансу скобок вне строк, не разбирая его
+    std::string_view SkipValue() {
+        char c;
+        if (!NextNonSpace(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        PutBack();
+        const char* begin = GetPosition();
+        const char* pos = begin;
+        const char* end = GetEnd();
+        int depth = 0;
+        // Между структурными символами вне строк пропускаются целые блоки
+        while ((pos = FindFirstOf<'"', '{', '[', '}', ']', ','>(pos, end)) != end) {
+            const char ch = *pos;
+            if (ch == '"') {
+                for (pos = FindFirstOf<'"', '\\'>(pos + 1, end); pos != end && *pos != '"';
+                     pos = FindFirstOf<'"', '\\'>(pos, end)) {
+                    // Экранированный символ пропускается вместе с обратной косой чертой
+                    pos = pos + 1 != end ? pos + 2 : end;
+                }
+                if (pos == end) {
+                    throw ParsingError("String parsing error"s);
+                }
+            } else if (ch == '{' || ch == '[') {
+                ++depth;
+            } else if (ch == '}' || ch == ']') {
+                if (depth == 0) {
+                    break;
+                }
+                --depth;
+            } else if (ch == ',' && depth == 0) {
                 break;
-            case '\n':
-                out << "\\n"sv;
+            }
+            ++pos;
+            if (depth == 0 && (ch == '}' || ch == ']' || ch == '"')) {
                 break;
-            case '\t':
-                out << "\\t"sv;
+            }
+        }
+        if (depth != 0) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        SetPosition(pos);
+        // Скалярное значение заканчивается перед разделителем: хвостовые пробелы отбрасываются
+        while (pos != begin && IsSpace(pos[-1])) {
+            --pos;
+        }
+        return std::string_view(begin, pos - begin);
+    }
+
+    // Читает строку после открывающей кавычки. Строка без escape-последовательностей
+    // возвращается как участок буфера, иначе раскодируется в scratch
+    std::string_view LoadStringView(std::string& scratch) {
+        const char* chunk = pos_;
+        pos_ = FindStringSpecial(pos_, end_);
+        if (pos_ != end_ && *pos_ == '"') {
+            ++pos_;
+            return {chunk, static_cast<size_t>(pos_ - 1 - chunk)};
+        }
+
+        scratch.assign(chunk, pos_);
+        while (true) {
+            // Участок без спецсимволов копируется целиком
+            chunk = pos_;
+            pos_ = FindStringSpecial(pos_, end_);
+            scratch.append(chunk, pos_);
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error");
+            }
+            const char ch = *pos_++;
+            if (ch == '"') {
                 break;
+            } else if (ch == '\\') {
+                if (pos_ == end_) {
+                    throw ParsingError("String parsing error");
+                }
+                const char escaped_char = *pos_++;
+                switch (escaped_char) {
+                    case 'n':
+                        scratch.push_back('\n');
+                        break;
+                    case 't':
+                        scratch.push_back('\t');
+                        break;
+                    case 'r':
+                        scratch.push_back('\r');
+                        break;
+                    case '"':
+                        scratch.push_back('"');
+                        break;
+                    case '\\':
+                        scratch.push_back('\\');
+                        break;
+                    default:
+                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            } else {
+                throw ParsingError("Unexpected end of line"s);
+            }
+        }
+        return scratch;
+    }
+
+    std::string LoadStringValue() {
+        std::string scratch;
+        const std::string_view value = LoadStringView(scratch);
+        if (value.data() == scratch.data()) {
+            return scratch;
+        }
+        return std::string(value);
+    }
+
+    bool LoadBoolValue() {
+        const auto s = LoadLiteral();
+        if (s == "true"sv) {
+            return true;
+        } else if (s == "false"sv) {
+            return false;
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+        }
+    }
+
+    void LoadNullValue() {
+        if (auto literal = LoadLiteral(); literal != "null"sv) {
+            throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+        }
+    }
+
+    Node LoadNumber() {
+        bool is_int = true;
+        const std::string_view text = ScanNumber(is_int);
+        return ConvertNumber(text, is_int);
+    }
+
+    // Проверяет запись числа и возвращает её без преобразования; is_int — нет
+    // дробной части и порядка
+    std::string_view ScanNumber(bool& is_int) {
+        const char* begin = pos_;
+
+        auto read_char = [this] {
+            if (pos_ == end_) {
+                throw ParsingError("Failed to read number from stream"s);
+            }
+            ++pos_;
+        };
+
+        auto read_digits = [this, read_char] {
+            if (!IsDigit(static_cast<char>(Peek()))) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (pos_ != end_ && IsDigit(*pos_)) {
+                read_char();
+            }
+        };
+
+        if (Peek() == '-') {
+            read_char();
+        }
+        if (Peek() == '0') {
+            read_char();
+        } else {
+            read_digits();
+        }
+
+        is_int = true;
+        if (Peek() == '.') {
+            read_char();
+            read_digits();
+            is_int = false;
+        }
+
+        if (int ch = Peek(); ch == 'e' || ch == 'E') {
+            read_char();
+            if (ch = Peek(); ch == '+' || ch == '-') {
+                read_char();
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        return std::string_view(begin, pos_ - begin);
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+// Построение дерева Node из буфера
+class BufferParser : private BufferScanner {
+public:
+    using BufferScanner::BufferScanner;
+    using BufferScanner::GetPosition;
+
+    Node LoadNode() {
+        char c;
+        if (!NextNonSpace(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+            case '[':
+                return LoadArray();
+            case '{':
+                return LoadDict();
             case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
+                return Node(LoadStringValue());
+            case 't':
                 [[fallthrough]];
+            case 'f':
+                PutBack();
+                return Node{LoadBoolValue()};
+            case 'n':
+                PutBack();
+                LoadNullValue();
+                return Node{nullptr};
             default:
-                out.put(c);
+                PutBack();
+                return LoadNumber();
+        }
+    }
+
+private:
+    // Словари длиннее этого проверяются на повтор ключей после сортировки, а не перебором
+    static constexpr size_t LINEAR_DUPLICATE_CHECK = 32;
+
+    // Элементы массивов и словарей сначала копятся в общих на весь документ стеках,
+    // а затем переносятся в контейнер точного размера одним выделением
+    Node LoadArray() {
+        const size_t mark = array_stack_.size();
+
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == ']') {
+                closed = true;
                 break;
+            }
+            if (c != ',') {
+                PutBack();
+            }
+            Node item = LoadNode();
+            array_stack_.push_back(std::move(item));
+        }
+        if (!closed) {
+            throw ParsingError("Array parsing error"s);
         }
+        Array result(std::make_move_iterator(array_stack_.begin() + mark),
+                     std::make_move_iterator(array_stack_.end()));
+        array_stack_.erase(array_stack_.begin() + mark, array_stack_.end());
+        return Node(std::move(result));
     }
-    out.put('"');
-}
+
+    Node LoadDict() {
+        const size_t mark = dict_stack_.size();
+
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == '}') {
+                closed = true;
+                break;
+            }
+            if (c == '"') {
+                std::string key = LoadStringValue();
+                if (NextNonSpace(c) && c == ':') {
+                    if (dict_stack_.size() - mark <= LINEAR_DUPLICATE_CHECK) {
+                        for (size_t i = mark; i < dict_stack_.size(); ++i) {
+                            if (dict_stack_[i].first == key) {
+                                throw ParsingError("Duplicate key '"s + key + "' have been found");
+                            }
+                        }
+                    }
+                    Node value = LoadNode();
+                    dict_stack_.emplace_back(std::move(key), std::move(value));
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        if (!closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        Dict::Storage entries(std::make_move_iterator(dict_stack_.begin() + mark),
+                              std::make_move_iterator(dict_stack_.end()));
+        dict_stack_.erase(dict_stack_.begin() + mark, dict_stack_.end());
+        Dict dict(std::move(entries));
+        if (dict.size() > LINEAR_DUPLICATE_CHECK) {
+            const auto duplicate = std::adjacent_find(dict.begin(), dict.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first == rhs.first;
+            });
+            if (duplicate != dict.end()) {
+                throw ParsingError("Duplicate key '"s + duplicate->first + "' have been found");
+            }
+        }
+        return Node(std::move(dict));
+    }
+
+    std::vector<Node> array_stack_;
+    Dict::Storage dict_stack_;
+};
+
+// Событийный разбор буфера: вместо построения дерева вызываются методы обработчика
+class SaxParser : private BufferScanner {
+public:
+    SaxParser(std::string_view input, SaxHandler& handler)
+        : BufferScanner(input), handler_(handler) {
+    }
+
+    void ParseValue() {
+        char c;
+        if (!NextNonSpace(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+            case '[':
+                ParseArray();
+                break;
+            case '{':
+                ParseDict();
+                break;
+            case '"':
+                handler_.String(LoadStringView(scratch_));
+                break;
+            case 't':
+                [[fallthrough]];
+            case 'f':
+                PutBack();
+                handler_.Bool(LoadBoolValue());
+                break;
+            case 'n':
+                PutBack();
+                LoadNullValue();
+                handler_.Null();
+                break;
+            default: {
+                PutBack();
+                const Node number = LoadNumber();
+                if (number.IsInt()) {
+                    handler_.Int(number.AsInt());
+                } else {
+                    handler_.Double(number.AsDouble());
+                }
+            }
+        }
+    }
+
+private:
+    void ParseArray() {
+        handler_.StartArray();
+
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == ']') {
+                closed = true;
+                break;
+            }
+            if (c != ',') {
+                PutBack();
+            }
+            ParseValue();
+        }
+        if (!closed) {
+            throw ParsingError("Array parsing error"s);
+        }
+        handler_.EndArray();
+    }
+
+    void ParseDict() {
+        handler_.StartDict();
+
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == '}') {
+                closed = true;
+                break;
+            }
+            if (c == '"') {
+                const std::string_view key = LoadStringView(scratch_);
+                if (NextNonSpace(c) && c == ':') {
+                    handler_.Key(key);
+                    ParseValue();
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        if (!closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        handler_.EndDict();
+    }
+
+    SaxHandler& handler_;
+    std::string scratch_;
+};
+
+// Поиск значения ключа корневого словаря без разбора остальных значений в дерево
+class MemberFinder : private BufferScanner {
+public:
+    using BufferScanner::BufferScanner;
+
+    std::optional<std::string_view> Find(std::string_view key) {
+        char c;
+        if (!NextNonSpace(c) || c != '{') {
+            throw ParsingError("Dictionary is expected"s);
+        }
+        std::string scratch;
+        while (NextNonSpace(c)) {
+            if (c == '}') {
+                return std::nullopt;
+            }
+            if (c == '"') {
+                const bool found = LoadStringView(scratch) == key;
+                if (!NextNonSpace(c) || c != ':') {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+                const std::string_view value = SkipValue();
+                if (found) {
+                    return value;
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        throw ParsingError("Dictionary parsing error"s);
+    }
+};
+
+// Границы элементов массива без разбора самих элементов
+class ArraySplitter : private BufferScanner {
+public:
+    using BufferScanner::BufferScanner;
+
+    std::vector<std::string_view> Split() {
+        char c;
+        if (!NextNonSpace(c) || c != '[') {
+            throw ParsingError("Array is expected"s);
+        }
+        std::vector<std::string_view> items;
+        while (NextNonSpace(c)) {
+            if (c == ']') {
+                return items;
+            }
+            if (c != ',') {
+                PutBack();
+            }
+            items.push_back(SkipValue());
+        }
+        throw ParsingError("Array parsing error"s);
+    }
+};
+
+// Раскодирует строку, текст которой начинается сразу за открывающей кавычкой
+class StringDecoder : private BufferScanner {
+public:
+    using BufferScanner::BufferScanner;
+
+    std::string Decode() {
+        return LoadStringValue();
+    }
+};
+
+struct PrintContext {
+    Writer& out;
+    int indent_step = Writer::INDENT_STEP;
+    int indent = 0;
+
+    bool IsCompact() const {
+        return out.GetOptions().compact;
+    }
+
+    // Перевод строки и отступ перед элементом; в компактном режиме ничего
+    void PrintNewLine() const {
+        if (!IsCompact()) {
+            out.Put('\n');
+            out.AppendSpaces(indent);
+        }
+    }
+
+    PrintContext Indented() const {
+        return {out, indent_step, indent_step + indent};
+    }
+};
+
+void PrintNode(const Node& value, const PrintContext& ctx);
+
+template <typename Value>
+void PrintValue(const Value& value, const PrintContext& ctx);
 
 template <>
-void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-    PrintString(value, ctx.out);
+void PrintValue<std::string_view>(const std::string_view& value, const PrintContext& ctx) {
+    ctx.out.WriteString(value);
 }
 
 template <>
 void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-    ctx.out << "null"sv;
+    ctx.out.Append("null"sv);
 }
 
 // В специализации шаблона PrintValue для типа bool параметр value передаётся
@@ -288,67 +850,856 @@ void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx)
 // void PrintValue(bool value, const PrintContext& ctx);
 template <>
 void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-    ctx.out << (value ? "true"sv : "false"sv);
+    ctx.out.Append(value ? "true"sv : "false"sv);
+}
+
+template <>
+void PrintValue<int>(const int& value, const PrintContext& ctx) {
+    ctx.out.WriteInt(value);
+}
+
+template <>
+void PrintValue<double>(const double& value, const PrintContext& ctx) {
+    ctx.out.WriteDouble(value);
 }
 
 template <>
 void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "[\n"sv;
+    Writer& out = ctx.out;
+    out.Put('[');
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const Node& node : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.Put(',');
         }
-        inner_ctx.PrintIndent();
+        inner_ctx.PrintNewLine();
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put(']');
+    // Пустой массив по-прежнему выводится на двух строках
+    if (nodes.empty() && !ctx.IsCompact()) {
+        out.Put('\n');
+    }
+    ctx.PrintNewLine();
+    out.Put(']');
 }
 
 template <>
 void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "{\n"sv;
+    Writer& out = ctx.out;
+    out.Put('{');
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const auto& [key, node] : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.Put(',');
         }
-        inner_ctx.PrintIndent();
-        PrintString(key, ctx.out);
-        out << ": "sv;
+        inner_ctx.PrintNewLine();
+        out.WriteString(key);
+        out.Append(ctx.IsCompact() ? ":"sv : ": "sv);
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put('}');
+    if (nodes.empty() && !ctx.IsCompact()) {
+        out.Put('\n');
+    }
+    ctx.PrintNewLine();
+    out.Put('}');
 }
 
 void PrintNode(const Node& node, const PrintContext& ctx) {
-    std::visit(
-        [&ctx](const auto& value) {
-            PrintValue(value, ctx);
-        },
-        node.GetValue());
+    node.Visit([&ctx](const auto& value) {
+        PrintValue(value, ctx);
+    });
 }
 
 }  // namespace
 
+Document Load(std::string_view input) {
+    return Document{BufferParser(input).LoadNode()};
+}
+
+void Parse(std::string_view input, SaxHandler& handler) {
+    SaxParser(input, handler).ParseValue();
+}
+
+void DomBuilder::AddValue(Node value) {
+    if (stack_.empty()) {
+        root_ = std::move(value);
+        return;
+    }
+    Node& top = stack_.back();
+    if (top.IsArray()) {
+        const_cast<Array&>(top.AsArray()).push_back(std::move(value));
+    } else {
+        dict_entries_.emplace_back(std::move(keys_.back()), std::move(value));
+        keys_.pop_back();
+    }
+}
+
+void DomBuilder::Null() {
+    AddValue(nullptr);
+}
+
+void DomBuilder::Bool(bool value) {
+    AddValue(value);
+}
+
+void DomBuilder::Int(int value) {
+    AddValue(value);
+}
+
+void DomBuilder::Double(double value) {
+    AddValue(value);
+}
+
+void DomBuilder::String(std::string_view value) {
+    AddValue(Node(value));
+}
+
+void DomBuilder::StartDict() {
+    // Сам словарь создаётся в EndDict, в стеке для него держится только место
+    stack_.emplace_back(nullptr);
+    dict_marks_.push_back(dict_entries_.size());
+}
+
+void DomBuilder::Key(std::string_view key) {
+    keys_.emplace_back(key);
+}
+
+void DomBuilder::EndDict() {
+    const size_t mark = dict_marks_.back();
+    dict_marks_.pop_back();
+    Dict::Storage entries(std::make_move_iterator(dict_entries_.begin() + mark),
+                          std::make_move_iterator(dict_entries_.end()));
+    dict_entries_.erase(dict_entries_.begin() + mark, dict_entries_.end());
+    Dict dict(std::move(entries));
+    const auto duplicate = std::adjacent_find(dict.begin(), dict.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first == rhs.first;
+    });
+    if (duplicate != dict.end()) {
+        throw ParsingError("Duplicate key '"s + duplicate->first + "' have been found");
+    }
+    stack_.pop_back();
+    AddValue(std::move(dict));
+}
+
+void DomBuilder::StartArray() {
+    stack_.emplace_back(Array{});
+}
+
+void DomBuilder::EndArray() {
+    Node array = std::move(stack_.back());
+    stack_.pop_back();
+    AddValue(std::move(array));
+}
+
+Node DomBuilder::ExtractRoot() {
+    return std::move(root_);
+}
+
+void Emit(const Node& node, SaxHandler& handler) {
+    node.Visit([&handler](const auto& value) {
+        using Value = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<Value, Array>) {
+            handler.StartArray();
+            for (const Node& item : value) {
+                Emit(item, handler);
+            }
+            handler.EndArray();
+        } else if constexpr (std::is_same_v<Value, Dict>) {
+            handler.StartDict();
+            for (const auto& [key, item] : value) {
+                handler.Key(key);
+                Emit(item, handler);
+            }
+            handler.EndDict();
+        } else if constexpr (std::is_same_v<Value, bool>) {
+            handler.Bool(value);
+        } else if constexpr (std::is_same_v<Value, int>) {
+            handler.Int(value);
+        } else if constexpr (std::is_same_v<Value, double>) {
+            handler.Double(value);
+        } else if constexpr (std::is_same_v<Value, std::string_view>) {
+            handler.String(value);
+        } else {
+            handler.Null();
+        }
+    });
+}
+
+std::optional<std::string_view> FindMember(std::string_view input, std::string_view key) {
+    return MemberFinder(input).Find(key);
+}
+
+std::vector<std::string_view> SplitArray(std::string_view input) {
+    return ArraySplitter(input).Split();
+}
+
+ArrayReader::ArrayReader(std::string_view input)
+    : pos_(input.data()), end_(input.data() + input.size()) {
+    while (pos_ != end_ && std::isspace(static_cast<unsigned char>(*pos_))) {
+        ++pos_;
+    }
+    if (pos_ == end_ || *pos_ != '[') {
+        throw ParsingError("Array is expected"s);
+    }
+    ++pos_;
+}
+
+std::optional<Node> ArrayReader::Next() {
+    if (!SkipToItem()) {
+        return std::nullopt;
+    }
+    BufferParser parser(std::string_view(pos_, end_ - pos_));
+    Node node = parser.LoadNode();
+    pos_ = parser.GetPosition();
+    return node;
+}
+
+bool ArrayReader::Next(LazyDocument& document) {
+    if (!SkipToItem()) {
+        return false;
+    }
+    pos_ = document.Index(std::string_view(pos_, end_ - pos_));
+    return true;
+}
+
+bool ArrayReader::SkipToItem() {
+    // Разделители разбираются так же снисходительно, как в Load
+    if (finished_) {
+        return false;
+    }
+    while (pos_ != end_ && std::isspace(static_cast<unsigned char>(*pos_))) {
+        ++pos_;
+    }
+    if (pos_ == end_) {
+        throw ParsingError("Array parsing error"s);
+    }
+    if (*pos_ == ']') {
+        ++pos_;
+        finished_ = true;
+        return false;
+    }
+    if (*pos_ == ',') {
+        ++pos_;
+    }
+    return true;
+}
+
+// Первый проход: грамматика та же, что у BufferParser, но вместо узлов на ленту
+// пишутся тип и границы значений. Строки проверяются целиком, числа — по записи
+class LazyDocument::Indexer : private BufferScanner {
+public:
+    using Kind = TapeEntry::Kind;
+
+    Indexer(std::string_view input, std::vector<TapeEntry>& tape)
+        : BufferScanner(input), begin_(input.data()), tape_(tape) {
+    }
+
+    using BufferScanner::GetPosition;
+
+    void IndexValue() {
+        char c;
+        if (!NextNonSpace(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+            case '[':
+                IndexArray();
+                break;
+            case '{':
+                IndexDict();
+                break;
+            case '"':
+                IndexString();
+                break;
+            case 't':
+                [[fallthrough]];
+            case 'f': {
+                PutBack();
+                const char* begin = GetPosition();
+                const bool value = LoadBoolValue();
+                Push(Kind::Bool, value, begin, GetPosition());
+                break;
+            }
+            case 'n': {
+                PutBack();
+                const char* begin = GetPosition();
+                LoadNullValue();
+                Push(Kind::Null, false, begin, GetPosition());
+                break;
+            }
+            default: {
+                PutBack();
+                bool is_int = true;
+                const std::string_view text = ScanNumber(is_int);
+                Push(Kind::Number, is_int, text.data(), text.data() + text.size());
+            }
+        }
+    }
+
+private:
+    uint32_t Push(Kind kind, bool flag, const char* begin, const char* end) {
+        const auto index = static_cast<uint32_t>(tape_.size());
+        tape_.push_back({kind, flag, static_cast<uint32_t>(begin - begin_), static_cast<uint32_t>(end - begin), index + 1});
+        return index;
+    }
+
+    void IndexString() {
+        const char* begin = GetPosition();
+        const std::string_view value = LoadStringView(scratch_);
+        // Строка с escape-последовательностями раскодирована в scratch_, а не указывает во вход
+        const bool escaped = value.data() == scratch_.data();
+        Push(Kind::String, escaped, begin, GetPosition() - 1);
+    }
+
+    void IndexArray() {
+        const uint32_t index = Push(Kind::Array, false, GetPosition() - 1, GetPosition());
+        uint32_t count = 0;
+
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == ']') {
+                closed = true;
+                break;
+            }
+            if (c != ',') {
+                PutBack();
+            }
+            IndexValue();
+            ++count;
+        }
+        if (!closed) {
+            throw ParsingError("Array parsing error"s);
+        }
+        Close(index, count);
+    }
+
+    void IndexDict() {
+        const uint32_t index = Push(Kind::Dict, false, GetPosition() - 1, GetPosition());
+        uint32_t count = 0;
+
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == '}') {
+                closed = true;
+                break;
+            }
+            if (c == '"') {
+                IndexString();
+                if (NextNonSpace(c) && c == ':') {
+                    IndexValue();
+                    ++count;
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        if (!closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        Close(index, count);
+    }
+
+    void Close(uint32_t index, uint32_t count) {
+        tape_[index].length = count;
+        tape_[index].next = static_cast<uint32_t>(tape_.size());
+    }
+
+    const char* begin_;
+    std::vector<TapeEntry>& tape_;
+    std::string scratch_;
+};
+
+LazyDocument::LazyDocument(std::string_view input) {
+    Index(input);
+}
+
+void LazyDocument::Load(std::string_view input) {
+    Index(input);
+}
+
+LazyNode LazyDocument::GetRoot() const {
+    return LazyNode(*this, 0);
+}
+
+const char* LazyDocument::Index(std::string_view input) {
+    // Смещения на ленте 32-битные
+    if (input.size() > std::numeric_limits<uint32_t>::max()) {
+        throw ParsingError("Document is too large"s);
+    }
+    input_ = input;
+    tape_.clear();
+    binary_numbers_ = false;
+    Indexer indexer(input, tape_);
+    indexer.IndexValue();
+    return indexer.GetPosition();
+}
+
+LazyDocument::Builder::Builder(LazyDocument& document)
+    : document_(document) {
+    Reset();
+}
+
+void LazyDocument::Builder::Reset() {
+    document_.input_ = {};
+    document_.tape_.clear();
+    document_.storage_.clear();
+    document_.binary_numbers_ = true;
+    open_.clear();
+}
+
+bool LazyDocument::Builder::IsComplete() const {
+    return open_.empty() && !document_.tape_.empty();
+}
+
+uint32_t LazyDocument::Builder::Push(Kind kind, bool flag, std::string_view data, bool is_value) {
+    if (IsComplete()) {
+        throw ParsingError("Document has more than one root value"s);
+    }
+    auto& storage = document_.storage_;
+    // Смещения на ленте 32-битные
+    if (data.size() > std::numeric_limits<uint32_t>::max() - storage.size()) {
+        throw ParsingError("Document is too large"s);
+    }
+    if (is_value && !open_.empty()) {
+        ++document_.tape_[open_.back()].length;
+    }
+    const auto index = static_cast<uint32_t>(document_.tape_.size());
+    document_.tape_.push_back({kind, flag, static_cast<uint32_t>(storage.size()), static_cast<uint32_t>(data.size()), index + 1});
+    storage.append(data);
+    // Буфер мог переехать при росте
+    document_.input_ = storage;
+    return index;
+}
+
+void LazyDocument::Builder::Close() {
+    document_.tape_[open_.back()].next = static_cast<uint32_t>(document_.tape_.size());
+    open_.pop_back();
+}
+
+void LazyDocument::Builder::Null() {
+    Push(Kind::Null, false, {});
+}
+
+void LazyDocument::Builder::Bool(bool value) {
+    Push(Kind::Bool, value, {});
+}
+
+void LazyDocument::Builder::Int(int value) {
+    // Целое хранится как double без потерь, флаг сохраняет выбор int при чтении
+    const double number = value;
+    Push(Kind::Number, true, std::string_view(reinterpret_cast<const char*>(&number), sizeof(number)));
+}
+
+void LazyDocument::Builder::Double(double value) {
+    Push(Kind::Number, false, std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)));
+}
+
+void LazyDocument::Builder::String(std::string_view value) {
+    Push(Kind::String, false, value);
+}
+
+void LazyDocument::Builder::StartDict() {
+    open_.push_back(Push(Kind::Dict, false, {}));
+}
+
+void LazyDocument::Builder::Key(std::string_view key) {
+    Push(Kind::String, false, key, false);
+}
+
+void LazyDocument::Builder::EndDict() {
+    Close();
+}
+
+void LazyDocument::Builder::StartArray() {
+    open_.push_back(Push(Kind::Array, false, {}));
+}
+
+void LazyDocument::Builder::EndArray() {
+    Close();
+}
+
+LazyNode::Iterator::Iterator(const LazyDocument& document, uint32_t index)
+    : document_(&document), index_(index) {
+}
+
+LazyNode LazyNode::Iterator::operator*() const {
+    return LazyNode(*document_, index_);
+}
+
+LazyNode::Iterator& LazyNode::Iterator::operator++() {
+    index_ = document_->tape_[index_].next;
+    return *this;
+}
+
+bool LazyNode::Iterator::operator==(const Iterator& other) const {
+    return document_ == other.document_ && index_ == other.index_;
+}
+
+bool LazyNode::Iterator::operator!=(const Iterator& other) const {
+    return !(*this == other);
+}
+
+LazyNode::LazyNode(const LazyDocument& document, uint32_t index)
+    : document_(&document), index_(index) {
+}
+
+const LazyDocument::TapeEntry& LazyNode::GetEntry() const {
+    return document_->tape_[index_];
+}
+
+std::string_view LazyNode::GetText() const {
+    const auto& entry = GetEntry();
+    return document_->input_.substr(entry.begin, entry.length);
+}
+
+bool LazyNode::IsNull() const {
+    return GetEntry().kind == LazyDocument::TapeEntry::Kind::Null;
+}
+
+bool LazyNode::IsBool() const {
+    return GetEntry().kind == LazyDocument::TapeEntry::Kind::Bool;
+}
+
+bool LazyNode::IsInt() const {
+    return IsDouble() && DecodeNumber().IsInt();
+}
+
+bool LazyNode::IsPureDouble() const {
+    return IsDouble() && DecodeNumber().IsPureDouble();
+}
+
+bool LazyNode::IsDouble() const {
+    return GetEntry().kind == LazyDocument::TapeEntry::Kind::Number;
+}
+
+bool LazyNode::IsString() const {
+    return GetEntry().kind == LazyDocument::TapeEntry::Kind::String;
+}
+
+bool LazyNode::IsArray() const {
+    return GetEntry().kind == LazyDocument::TapeEntry::Kind::Array;
+}
+
+bool LazyNode::IsDict() const {
+    return GetEntry().kind == LazyDocument::TapeEntry::Kind::Dict;
+}
+
+bool LazyNode::AsBool() const {
+    if (!IsBool()) {
+        throw std::logic_error("Not a bool"s);
+    }
+    return GetEntry().flag;
+}
+
+int LazyNode::AsInt() const {
+    if (!IsDouble()) {
+        throw std::logic_error("Not an int"s);
+    }
+    return DecodeNumber().AsInt();
+}
+
+double LazyNode::AsDouble() const {
+    if (!IsDouble()) {
+        throw std::logic_error("Not a double"s);
+    }
+    return DecodeNumber().AsDouble();
+}
+
+std::string LazyNode::AsString() const {
+    if (!IsString()) {
+        throw std::logic_error("Not a string"s);
+    }
+    if (!GetEntry().flag) {
+        return std::string(GetText());
+    }
+    return StringDecoder(document_->input_.substr(GetEntry().begin)).Decode();
+}
+
+size_t LazyNode::size() const {
+    if (!IsArray() && !IsDict()) {
+        throw std::logic_error("Not an array or dict"s);
+    }
+    return GetEntry().length;
+}
+
+LazyNode::Iterator LazyNode::begin() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    return Iterator(*document_, index_ + 1);
+}
+
+LazyNode::Iterator LazyNode::end() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    return Iterator(*document_, GetEntry().next);
+}
+
+LazyNode LazyNode::at(std::string_view key) const {
+    const auto index = Find(key);
+    if (!index) {
+        throw std::out_of_range("Dict::at");
+    }
+    return LazyNode(*document_, *index);
+}
+
+size_t LazyNode::count(std::string_view key) const {
+    return Find(key) ? 1 : 0;
+}
+
+Node LazyNode::Materialize() const {
+    switch (GetEntry().kind) {
+        case LazyDocument::TapeEntry::Kind::Bool:
+            return AsBool();
+        case LazyDocument::TapeEntry::Kind::Number:
+            return DecodeNumber();
+        case LazyDocument::TapeEntry::Kind::String:
+            return AsString();
+        case LazyDocument::TapeEntry::Kind::Array: {
+            Array result;
+            result.reserve(size());
+            for (const LazyNode item : *this) {
+                result.push_back(item.Materialize());
+            }
+            return result;
+        }
+        case LazyDocument::TapeEntry::Kind::Dict: {
+            Dict result;
+            const auto& tape = document_->tape_;
+            for (uint32_t key = index_ + 1; key < GetEntry().next; key = tape[key + 1].next) {
+                result.emplace(LazyNode(*document_, key).AsString(), LazyNode(*document_, key + 1).Materialize());
+            }
+            return result;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+Node LazyNode::DecodeNumber() const {
+    if (document_->binary_numbers_) {
+        double value = 0.0;
+        std::memcpy(&value, GetText().data(), sizeof(value));
+        return GetEntry().flag ? Node(static_cast<int>(value)) : Node(value);
+    }
+    return ConvertNumber(GetText(), GetEntry().flag);
+}
+
+std::optional<uint32_t> LazyNode::Find(std::string_view key) const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict"s);
+    }
+    // Пары идут на ленте подряд: запись ключа, затем значение со всеми вложенными
+    const auto& tape = document_->tape_;
+    for (uint32_t index = index_ + 1; index < GetEntry().next; index = tape[index + 1].next) {
+        const LazyNode name(*document_, index);
+        if (tape[index].flag ? name.AsString() == key : name.GetText() == key) {
+            return index + 1;
+        }
+    }
+    return std::nullopt;
+}
+
+Writer::Writer(std::ostream& output, PrintOptions options)
+    : output_(output), options_(options) {
+    buffer_.reserve(BLOCK_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Put(char c) {
+    buffer_.push_back(c);
+    FlushIfFull();
+}
+
+void Writer::Append(std::string_view text) {
+    buffer_.append(text);
+    FlushIfFull();
+}
+
+void Writer::AppendSpaces(int count) {
+    buffer_.append(static_cast<size_t>(count), ' ');
+    FlushIfFull();
+}
+
+void Writer::WriteString(std::string_view value) {
+    buffer_.push_back('"');
+    // Участки без спецсимволов копируются целиком
+    const char* pos = value.data();
+    const char* end = value.data() + value.size();
+    while (true) {
+        const char* special = FindFirstOf<'\r', '\n', '\t', '"', '\\'>(pos, end);
+        buffer_.append(pos, special);
+        if (special == end) {
+            break;
+        }
+        switch (*special) {
+            case '\r':
+                buffer_.append("\\r"sv);
+                break;
+            case '\n':
+                buffer_.append("\\n"sv);
+                break;
+            case '\t':
+                buffer_.append("\\t"sv);
+                break;
+            default:
+                // Символы " и \ выводятся как \" или \\, соответственно
+                buffer_.push_back('\\');
+                buffer_.push_back(*special);
+                break;
+        }
+        pos = special + 1;
+    }
+    buffer_.push_back('"');
+    FlushIfFull();
+}
+
+void Writer::WriteInt(int value) {
+    char digits[16];
+    const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+    Append(std::string_view(digits, result.ptr - digits));
+}
+
+void Writer::WriteDouble(double value) {
+    // В JSON нет записи для nan и бесконечностей: такой текст не разобрать обратно
+    if (!std::isfinite(value)) {
+        throw std::domain_error("JSON cannot represent non-finite number "s + (std::isnan(value) ? "nan"s : "inf"s));
+    }
+    // Точности больше max_digits10 не добавляют информации
+    char digits[64];
+    const int precision = std::min(options_.precision, std::numeric_limits<double>::max_digits10);
+    const auto result = precision == SHORTEST_PRECISION
+        ? std::to_chars(std::begin(digits), std::end(digits), value)
+        : std::to_chars(std::begin(digits), std::end(digits), value, std::chars_format::general, precision);
+    Append(std::string_view(digits, result.ptr - digits));
+}
+
+void Writer::WriteNode(const Node& node, int indent) {
+    PrintNode(node, PrintContext{*this, INDENT_STEP, indent});
+}
+
+void Writer::Flush() {
+    if (!buffer_.empty()) {
+        output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+void Writer::FlushIfFull() {
+    if (buffer_.size() >= BLOCK_SIZE) {
+        Flush();
+    }
+}
+
+SaxPrinter::SaxPrinter(Writer& writer)
+    : writer_(writer) {}
+
+void SaxPrinter::Null() {
+    BeginValue();
+    writer_.Append("null"sv);
+}
+
+void SaxPrinter::Bool(bool value) {
+    BeginValue();
+    writer_.Append(value ? "true"sv : "false"sv);
+}
+
+void SaxPrinter::Int(int value) {
+    BeginValue();
+    writer_.WriteInt(value);
+}
+
+void SaxPrinter::Double(double value) {
+    BeginValue();
+    writer_.WriteDouble(value);
+}
+
+void SaxPrinter::String(std::string_view value) {
+    BeginValue();
+    writer_.WriteString(value);
+}
+
+void SaxPrinter::StartDict() {
+    BeginValue();
+    writer_.Put('{');
+    stack_.push_back({true});
+}
+
+void SaxPrinter::Key(std::string_view key) {
+    BeginItem();
+    writer_.WriteString(key);
+    writer_.Append(writer_.GetOptions().compact ? ":"sv : ": "sv);
+}
+
+void SaxPrinter::EndDict() {
+    EndContainer('}');
+}
+
+void SaxPrinter::StartArray() {
+    BeginValue();
+    writer_.Put('[');
+    stack_.push_back({false});
+}
+
+void SaxPrinter::EndArray() {
+    EndContainer(']');
+}
+
+// Значение словаря идёт сразу за ключом, перед элементом массива нужен разделитель
+void SaxPrinter::BeginValue() {
+    if (!stack_.empty() && !stack_.back().is_dict) {
+        BeginItem();
+    }
+}
+
+void SaxPrinter::BeginItem() {
+    Container& container = stack_.back();
+    if (!container.empty) {
+        writer_.Put(',');
+    }
+    container.empty = false;
+    NewLine();
+}
+
+void SaxPrinter::EndContainer(char bracket) {
+    const bool empty = stack_.back().empty;
+    stack_.pop_back();
+    // Как и в Print, пустой контейнер занимает две строки
+    if (empty && !writer_.GetOptions().compact) {
+        writer_.Put('\n');
+    }
+    NewLine();
+    writer_.Put(bracket);
+}
+
+void SaxPrinter::NewLine() {
+    if (!writer_.GetOptions().compact) {
+        writer_.Put('\n');
+        writer_.AppendSpaces(Writer::INDENT_STEP * static_cast<int>(stack_.size()));
+    }
+}
+
 Document Load(std::istream& input) {
     return Document{LoadNode(input)};
 }
 
-void Print(const Document& doc, std::ostream& output) {
-    PrintNode(doc.GetRoot(), PrintContext{output});
+void Print(const Document& doc, std::ostream& output, PrintOptions options) {
+    Writer writer(output, options);
+    writer.WriteNode(doc.GetRoot());
 }
 
 }  // namespace json
\ No newline at end of file
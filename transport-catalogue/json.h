@@ -1,43 +1,134 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
-#include <map>
+#include <stdexcept>
+#include <optional>
 #include <string>
-#include <variant>
+#include <string_view>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
 using Array = std::vector<Node>;
 
+// Словарь в виде отсортированного по ключу вектора пар: один блок памяти на весь
+// словарь вместо узла дерева на каждый ключ, короткие ключи хранятся внутри строк без
+// выделений. Интерфейс и порядок обхода совпадают с используемой частью std::map
+class Dict {
+public:
+    using value_type = std::pair<std::string, Node>;
+    using Storage = std::vector<value_type>;
+    using iterator = Storage::iterator;
+    using const_iterator = Storage::const_iterator;
+
+    Dict() = default;
+    // Пары в произвольном порядке, ключи должны быть уникальными
+    explicit Dict(Storage entries);
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const;
+    bool empty() const;
+
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    Node& at(std::string_view key);
+    const Node& at(std::string_view key) const;
+    Node& operator[](std::string_view key);
+    std::pair<iterator, bool> emplace(std::string key, Node value);
+
+    bool operator==(const Dict& other) const;
+
+private:
+    iterator LowerBound(std::string_view key);
+
+    Storage entries_;
+};
+
 class ParsingError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
 };
 
-class Node final
-    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+// Узел занимает 16 байт: тег типа и значение. Числа, bool и строки не длиннее
+// SHORT_STRING_CAPACITY байт хранятся внутри узла. Длинные строки одним блоком и
+// контейнеры лежат в куче и принадлежат узлу, поэтому перемещение узла не меняет
+// адресов вложенных элементов
+class Node final {
 public:
-    using variant::variant;
-	using Value = variant;
-    
-    Node(Value value) : variant(std::move(value)) {}
+    Node() = default;
+    Node(std::nullptr_t) {}
+    Node(Array value) {
+        storage_.boxed.type = Type::Array;
+        storage_.boxed.value.array = new Array(std::move(value));
+    }
+    Node(Dict value) {
+        storage_.boxed.type = Type::Dict;
+        storage_.boxed.value.dict = new Dict(std::move(value));
+    }
+    Node(bool value) {
+        storage_.boxed.type = Type::Bool;
+        storage_.boxed.value.boolean = value;
+    }
+    Node(int value) {
+        storage_.boxed.type = Type::Int;
+        storage_.boxed.value.integer = value;
+    }
+    Node(double value) {
+        storage_.boxed.type = Type::Double;
+        storage_.boxed.value.real = value;
+    }
+    Node(const std::string& value) {
+        SetString(value);
+    }
+    explicit Node(std::string_view value) {
+        SetString(value);
+    }
+    // Без этой перегрузки строковый литерал превращался бы в bool
+    Node(const char* value) {
+        SetString(value);
+    }
+
+    Node(const Node& other);
+    Node(Node&& other) noexcept
+        : storage_(other.storage_) {
+        other.storage_ = Storage{};
+    }
+    Node& operator=(const Node& other) {
+        Node copy(other);
+        return *this = std::move(copy);
+    }
+    Node& operator=(Node&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            storage_ = other.storage_;
+            other.storage_ = Storage{};
+        }
+        return *this;
+    }
+    ~Node() {
+        Reset();
+    }
 
     bool IsInt() const {
-        return std::holds_alternative<int>(*this);
+        return GetType() == Type::Int;
     }
     int AsInt() const {
         using namespace std::literals;
         if (!IsInt()) {
             throw std::logic_error("Not an int"s);
         }
-        return std::get<int>(*this);
+        return storage_.boxed.value.integer;
     }
 
     bool IsPureDouble() const {
-        return std::holds_alternative<double>(*this);
+        return GetType() == Type::Double;
     }
     bool IsDouble() const {
         return IsInt() || IsPureDouble();
@@ -47,11 +138,11 @@ public:
         if (!IsDouble()) {
             throw std::logic_error("Not a double"s);
         }
-        return IsPureDouble() ? std::get<double>(*this) : AsInt();
+        return IsPureDouble() ? storage_.boxed.value.real : AsInt();
     }
 
     bool IsBool() const {
-        return std::holds_alternative<bool>(*this);
+        return GetType() == Type::Bool;
     }
     bool AsBool() const {
         using namespace std::literals;
@@ -59,15 +150,15 @@ public:
             throw std::logic_error("Not a bool"s);
         }
 
-        return std::get<bool>(*this);
+        return storage_.boxed.value.boolean;
     }
 
     bool IsNull() const {
-        return std::holds_alternative<std::nullptr_t>(*this);
+        return GetType() == Type::Null;
     }
 
     bool IsArray() const {
-        return std::holds_alternative<Array>(*this);
+        return GetType() == Type::Array;
     }
     const Array& AsArray() const {
         using namespace std::literals;
@@ -75,23 +166,32 @@ public:
             throw std::logic_error("Not an array"s);
         }
 
-        return std::get<Array>(*this);
+        return *storage_.boxed.value.array;
     }
 
     bool IsString() const {
-        return std::holds_alternative<std::string>(*this);
+        return GetType() == Type::String || GetType() == Type::ShortString;
+    }
+    // Короткая строка лежит в самом узле, поэтому строка отдаётся копией, как
+    // в LazyNode::AsString
+    std::string AsString() const {
+        return std::string(AsStringView());
     }
-    const std::string& AsString() const {
+    // Строка без копирования; действительна, пока узел не изменён и не перемещён
+    std::string_view AsStringView() const {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
         }
 
-        return std::get<std::string>(*this);
+        if (GetType() == Type::ShortString) {
+            return {storage_.short_string.chars, storage_.short_string.size};
+        }
+        return {storage_.boxed.value.chars, storage_.boxed.size};
     }
 
     bool IsDict() const {
-        return std::holds_alternative<Dict>(*this);
+        return GetType() == Type::Dict;
     }
     const Dict& AsDict() const {
         using namespace std::literals;
@@ -99,25 +199,236 @@ public:
             throw std::logic_error("Not a dict"s);
         }
 
-        return std::get<Dict>(*this);
+        return *storage_.boxed.value.dict;
     }
 
-    bool operator==(const Node& rhs) const {
-        return GetValue() == rhs.GetValue();
+    bool operator==(const Node& rhs) const;
+
+    // Вызывает visitor со значением узла, как std::visit для прежнего variant.
+    // Строка передаётся как std::string_view
+    template <typename Visitor>
+    decltype(auto) Visit(Visitor&& visitor) const;
+
+private:
+    enum class Type : uint8_t { Null, Array, Dict, Bool, Int, Double, String, ShortString };
+
+    static constexpr size_t SHORT_STRING_CAPACITY = 14;
+
+    // Значение и длинная строка: длина строки занимает место между тегом и значением
+    struct Boxed {
+        Type type;
+        uint32_t size;
+        union {
+            bool boolean;
+            int integer;
+            double real;
+            Array* array;
+            Dict* dict;
+            char* chars;
+        } value;
+    };
+
+    struct ShortString {
+        Type type;
+        uint8_t size;
+        char chars[SHORT_STRING_CAPACITY];
+    };
+
+    // Оба варианта начинаются с тега, поэтому тег читается через boxed при любом
+    // активном варианте
+    union Storage {
+        Boxed boxed;
+        ShortString short_string;
+    };
+
+    Type GetType() const {
+        return storage_.boxed.type;
     }
 
-    const Value& GetValue() const {
-        return *this;
+    void SetString(std::string_view value);
+    void Reset() noexcept;
+
+    Storage storage_{};
+};
+
+static_assert(sizeof(Node) == 16);
+
+inline void Node::SetString(std::string_view value) {
+    if (value.size() <= SHORT_STRING_CAPACITY) {
+        storage_.short_string = ShortString{Type::ShortString, static_cast<uint8_t>(value.size()), {}};
+        std::copy(value.begin(), value.end(), storage_.short_string.chars);
+        return;
     }
-    Value& GetValue() {
-        return *this;
+    if (value.size() > UINT32_MAX) {
+        throw std::length_error("String is too long for json::Node");
     }
-};
+    storage_.boxed.type = Type::String;
+    storage_.boxed.size = static_cast<uint32_t>(value.size());
+    storage_.boxed.value.chars = new char[value.size()];
+    std::copy(value.begin(), value.end(), storage_.boxed.value.chars);
+}
+
+inline Node::Node(const Node& other)
+    : storage_(other.storage_) {
+    switch (GetType()) {
+        case Type::Array:
+            storage_.boxed.value.array = new Array(*other.storage_.boxed.value.array);
+            break;
+        case Type::Dict:
+            storage_.boxed.value.dict = new Dict(*other.storage_.boxed.value.dict);
+            break;
+        case Type::String:
+            SetString(other.AsStringView());
+            break;
+        default:
+            break;
+    }
+}
+
+inline void Node::Reset() noexcept {
+    switch (GetType()) {
+        case Type::Array:
+            delete storage_.boxed.value.array;
+            break;
+        case Type::Dict:
+            delete storage_.boxed.value.dict;
+            break;
+        case Type::String:
+            delete[] storage_.boxed.value.chars;
+            break;
+        default:
+            break;
+    }
+    storage_ = Storage{};
+}
+
+template <typename Visitor>
+decltype(auto) Node::Visit(Visitor&& visitor) const {
+    switch (GetType()) {
+        case Type::Array:
+            return visitor(*storage_.boxed.value.array);
+        case Type::Dict:
+            return visitor(*storage_.boxed.value.dict);
+        case Type::Bool:
+            return visitor(storage_.boxed.value.boolean);
+        case Type::Int:
+            return visitor(storage_.boxed.value.integer);
+        case Type::Double:
+            return visitor(storage_.boxed.value.real);
+        case Type::String:
+        case Type::ShortString:
+            return visitor(AsStringView());
+        default:
+            return visitor(nullptr);
+    }
+}
+
+inline bool Node::operator==(const Node& rhs) const {
+    if (GetType() != rhs.GetType()) {
+        return false;
+    }
+    switch (GetType()) {
+        case Type::Array:
+            return *storage_.boxed.value.array == *rhs.storage_.boxed.value.array;
+        case Type::Dict:
+            return *storage_.boxed.value.dict == *rhs.storage_.boxed.value.dict;
+        case Type::Bool:
+            return storage_.boxed.value.boolean == rhs.storage_.boxed.value.boolean;
+        case Type::Int:
+            return storage_.boxed.value.integer == rhs.storage_.boxed.value.integer;
+        case Type::Double:
+            return storage_.boxed.value.real == rhs.storage_.boxed.value.real;
+        case Type::String:
+        case Type::ShortString:
+            return AsStringView() == rhs.AsStringView();
+        default:
+            return true;
+    }
+}
 
 inline bool operator!=(const Node& lhs, const Node& rhs) {
     return !(lhs == rhs);
 }
 
+
+inline Dict::Dict(Storage entries)
+    : entries_(std::move(entries)) {
+    std::sort(entries_.begin(), entries_.end(), [](const value_type& lhs, const value_type& rhs) {
+        return lhs.first < rhs.first;
+    });
+}
+
+inline Dict::iterator Dict::begin() {
+    return entries_.begin();
+}
+
+inline Dict::iterator Dict::end() {
+    return entries_.end();
+}
+
+inline Dict::const_iterator Dict::begin() const {
+    return entries_.begin();
+}
+
+inline Dict::const_iterator Dict::end() const {
+    return entries_.end();
+}
+
+inline size_t Dict::size() const {
+    return entries_.size();
+}
+
+inline bool Dict::empty() const {
+    return entries_.empty();
+}
+
+inline Dict::iterator Dict::LowerBound(std::string_view key) {
+    return std::lower_bound(entries_.begin(), entries_.end(), key, [](const value_type& entry, std::string_view key) {
+        return std::string_view(entry.first) < key;
+    });
+}
+
+inline Dict::iterator Dict::find(std::string_view key) {
+    const auto it = LowerBound(key);
+    return it != entries_.end() && it->first == key ? it : entries_.end();
+}
+
+inline Dict::const_iterator Dict::find(std::string_view key) const {
+    return const_cast<Dict&>(*this).find(key);
+}
+
+inline size_t Dict::count(std::string_view key) const {
+    return find(key) != end() ? 1 : 0;
+}
+
+inline Node& Dict::at(std::string_view key) {
+    const auto it = find(key);
+    if (it == entries_.end()) {
+        throw std::out_of_range("Dict::at");
+    }
+    return it->second;
+}
+
+inline const Node& Dict::at(std::string_view key) const {
+    return const_cast<Dict&>(*this).at(key);
+}
+
+inline Node& Dict::operator[](std::string_view key) {
+    return emplace(std::string(key), Node{}).first->second;
+}
+
+inline std::pair<Dict::iterator, bool> Dict::emplace(std::string key, Node value) {
+    const auto it = LowerBound(key);
+    if (it != entries_.end() && it->first == key) {
+        return {it, false};
+    }
+    return {entries_.emplace(it, std::move(key), std::move(value)), true};
+}
+
+inline bool Dict::operator==(const Dict& other) const {
+    return entries_ == other.entries_;
+}
+
 class Document {
 public:
     explicit Document(Node root)
@@ -141,7 +452,342 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
 }
 
 Document Load(std::istream& input);
+// Разбор из непрерывного буфера (строки или отображённого в память файла);
+// заметно быстрее потокового варианта. Буфер нужен только на время разбора
+Document Load(std::string_view input);
+
+// Обработчик событий потокового (SAX) разбора. Строки и ключи передаются
+// представлениями, действительными только до возврата из обработчика
+class SaxHandler {
+public:
+    virtual ~SaxHandler() = default;
+
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value) = 0;
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+};
+
+// Разбирает буфер без построения дерева, сообщая обработчику о каждом значении.
+// Повторяющиеся ключи словаря не проверяются — это остаётся обработчику
+void Parse(std::string_view input, SaxHandler& handler);
+
+// Собирает дерево из событий. Пары словаря копятся в общем буфере и в EndDict
+// упорядочиваются одной сортировкой, как при разборе текста; повтор ключа — ошибка
+class DomBuilder final : public SaxHandler {
+public:
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+
+    Node ExtractRoot();
+
+private:
+    void AddValue(Node value);
+
+    std::vector<Node> stack_;
+    std::vector<std::string> keys_;
+    Dict::Storage dict_entries_;
+    std::vector<size_t> dict_marks_;
+    Node root_;
+};
+
+// Сообщает обработчику о значениях дерева в порядке обхода, как это сделал бы
+// разбор его текста; позволяет выводить готовые узлы в любой приёмник событий
+void Emit(const Node& node, SaxHandler& handler);
+
+// Текст значения ключа key корневого словаря input, если ключ есть. Остальные
+// значения пропускаются по балансу скобок без разбора, поэтому input должен быть
+// уже проверенным документом
+std::optional<std::string_view> FindMember(std::string_view input, std::string_view key);
+
+// Тексты элементов массива input. Элементы пропускаются по балансу скобок, как в
+// FindMember, и проверяются только при разборе каждого из них, поэтому их можно
+// разбирать независимо, в том числе в разных потоках
+std::vector<std::string_view> SplitArray(std::string_view input);
+
+class LazyNode;
+
+// Двухэтапный разбор. Первый проход проверяет синтаксис и записывает на ленту
+// тип и границы каждого значения, второй раскодирует значения по запросу через
+// LazyNode. Документ ссылается на входной буфер и не копирует его; документ,
+// собранный из событий Builder, хранит значения сам
+class LazyDocument {
+public:
+    class Builder;
+
+    LazyDocument() = default;
+    explicit LazyDocument(std::string_view input);
+    // Документ, собранный событиями, ссылается на собственный буфер
+    LazyDocument(const LazyDocument&) = delete;
+    LazyDocument& operator=(const LazyDocument&) = delete;
+
+    // Индексирует новый документ на месте прежнего; память ленты переиспользуется
+    void Load(std::string_view input);
+
+    LazyNode GetRoot() const;
+
+private:
+    friend class LazyNode;
+    friend class ArrayReader;
+    class Indexer;
+
+    struct TapeEntry {
+        enum class Kind : uint8_t { Null, Bool, Number, String, Array, Dict };
+
+        Kind kind = Kind::Null;
+        // Значение Bool, запись Number без дробной части и порядка,
+        // escape-последовательности в String
+        bool flag = false;
+        // Смещение текста значения во входе: для строк без кавычек
+        uint32_t begin = 0;
+        // Длина текста скаляра или число элементов контейнера
+        uint32_t length = 0;
+        // Номер записи, следующей за значением со всеми вложенными
+        uint32_t next = 0;
+    };
+
+    // Индексирует одно значение с начала input, заменяя содержимое ленты;
+    // память ленты переиспользуется. Возвращает позицию за значением
+    const char* Index(std::string_view input);
+
+    std::string_view input_;
+    std::vector<TapeEntry> tape_;
+    // Значения документа, собранного Builder; input_ тогда указывает сюда
+    std::string storage_;
+    // Числа записаны в storage_ как double, а не текстом
+    bool binary_numbers_ = false;
+};
+
+// Заполняет ленту документа событиями разбора другого формата, например CBOR.
+// Строки и числа копируются в собственный буфер документа: строки как есть,
+// числа в двоичном виде, поэтому обратно в текст ничего не перекодируется
+class LazyDocument::Builder final : public SaxHandler {
+public:
+    explicit Builder(LazyDocument& document);
+
+    // Начинает новый документ на месте прежнего; память переиспользуется
+    void Reset();
+    // Корень документа собран целиком
+    bool IsComplete() const;
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+
+private:
+    using Kind = TapeEntry::Kind;
+
+    // Дописывает запись со значением data; контейнер учитывается в родителе
+    uint32_t Push(Kind kind, bool flag, std::string_view data, bool is_value = true);
+    void Close();
+
+    LazyDocument& document_;
+    // Открытые контейнеры
+    std::vector<uint32_t> open_;
+};
+
+// Значение ленивого документа: номер записи на ленте. Строки и числа раскодируются
+// при каждом обращении к As*, поэтому значение, которое не читали, не стоит ничего.
+// Интерфейс повторяет Node и Dict; действительно, пока жив документ
+class LazyNode {
+public:
+    // Обход элементов массива
+    class Iterator {
+    public:
+        LazyNode operator*() const;
+        Iterator& operator++();
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        friend class LazyNode;
+        Iterator(const LazyDocument& document, uint32_t index);
+
+        const LazyDocument* document_;
+        uint32_t index_;
+    };
+
+    bool IsNull() const;
+    bool IsBool() const;
+    bool IsInt() const;
+    bool IsPureDouble() const;
+    bool IsDouble() const;
+    bool IsString() const;
+    bool IsArray() const;
+    bool IsDict() const;
+
+    bool AsBool() const;
+    int AsInt() const;
+    double AsDouble() const;
+    std::string AsString() const;
+
+    // Число элементов массива или пар словаря
+    size_t size() const;
+    Iterator begin() const;
+    Iterator end() const;
+
+    // Значение ключа словаря; при повторе ключа берётся первое
+    LazyNode at(std::string_view key) const;
+    size_t count(std::string_view key) const;
+
+    // Обходит пары словаря по порядку: func(std::string_view key, const LazyNode& value).
+    // Ключ без escape-последовательностей передаётся прямо из входного текста
+    template <typename Func>
+    void ForEachMember(Func&& func) const;
+
+    // Значение целиком в виде дерева
+    Node Materialize() const;
+
+private:
+    friend class LazyDocument;
+    LazyNode(const LazyDocument& document, uint32_t index);
+
+    const LazyDocument::TapeEntry& GetEntry() const;
+    std::string_view GetText() const;
+    // Число с тем же выбором int или double, что и при полном разборе
+    Node DecodeNumber() const;
+    std::optional<uint32_t> Find(std::string_view key) const;
+
+    const LazyDocument* document_;
+    uint32_t index_;
+};
+
+template <typename Func>
+void LazyNode::ForEachMember(Func&& func) const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict");
+    }
+    const auto& tape = document_->tape_;
+    for (uint32_t index = index_ + 1; index < GetEntry().next; index = tape[index + 1].next) {
+        const LazyNode key(*document_, index);
+        const LazyNode value(*document_, index + 1);
+        if (tape[index].flag) {
+            func(std::string_view(key.AsString()), value);
+        } else {
+            func(key.GetText(), value);
+        }
+    }
+}
+
+// Последовательное чтение элементов массива из буфера: в Node разбирается
+// только очередной элемент, поэтому память не зависит от длины массива
+class ArrayReader {
+public:
+    explicit ArrayReader(std::string_view input);
+
+    // Очередной элемент или nullopt после закрывающей скобки
+    std::optional<Node> Next();
+    // Очередной элемент в виде ленивого документа; false после закрывающей скобки
+    bool Next(LazyDocument& document);
+
+private:
+    // Пропускает разделители перед элементом; false, если массив закончился
+    bool SkipToItem();
+
+    const char* pos_;
+    const char* end_;
+    bool finished_ = false;
+};
+
+// Кратчайшая запись вещественного числа, которая читается обратно без потерь
+inline constexpr int SHORTEST_PRECISION = 0;
+
+struct PrintOptions {
+    // Без пробелов и переводов строк между элементами
+    bool compact = false;
+    // Число значащих цифр вещественных чисел; 6 совпадает с выводом std::ostream
+    int precision = 6;
+};
+
+// Вывод копится в буфере и уходит в поток блоками по BLOCK_SIZE байт, числа
+// форматируются через std::to_chars без участия локали и манипуляторов потока
+class Writer {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr int INDENT_STEP = 4;
+
+    explicit Writer(std::ostream& output, PrintOptions options = {});
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer();
+
+    const PrintOptions& GetOptions() const {
+        return options_;
+    }
+
+    void Put(char c);
+    void Append(std::string_view text);
+    void AppendSpaces(int count);
+    // Строка в кавычках с экранированием
+    void WriteString(std::string_view value);
+    void WriteInt(int value);
+    // Бесконечности и nan в JSON не записываются: бросает std::domain_error
+    void WriteDouble(double value);
+    // Узел целиком; indent — отступ строки, на которой он начинается
+    void WriteNode(const Node& node, int indent = 0);
+    void Flush();
+
+private:
+    void FlushIfFull();
+
+    std::ostream& output_;
+    PrintOptions options_;
+    std::string buffer_;
+};
+
+// Приёмник событий, печатающий значения текстом в том же формате, что и Print.
+// Порядок событий не проверяется: за ним следит источник
+class SaxPrinter final : public SaxHandler {
+public:
+    explicit SaxPrinter(Writer& writer);
+
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+
+private:
+    struct Container {
+        bool is_dict = false;
+        bool empty = true;
+    };
+
+    void BeginValue();
+    void BeginItem();
+    void EndContainer(char bracket);
+    void NewLine();
+
+    Writer& writer_;
+    std::vector<Container> stack_;
+};
 
-void Print(const Document& doc, std::ostream& output);
+void Print(const Document& doc, std::ostream& output, PrintOptions options = {});
 
 }  // namespace json
\ No newline at end of file
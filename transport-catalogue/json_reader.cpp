@@ -1,4 +1,11 @@
 #include "json_reader.h"
+#include "cbor.h"
+#include "json_schema.h"
+#include "parallel.h"
+#include "perfect_hash.h"
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <sstream>
 
 namespace json_reader {
@@ -19,6 +26,8 @@ constexpr char ROUTE_LENGTH[] = "route_length";
 constexpr char STOP_COUNT[] = "stop_count";
 constexpr char UNIQUE_STOP_COUNT[] = "unique_stop_count";
 constexpr char REQUEST_ID[] = "request_id";
+constexpr char DELTA_REQUESTS[] = "delta_requests";
+constexpr char VERSION[] = "version";
 constexpr char BUS[] = "Bus";
 constexpr char STOP[] = "Stop";
 constexpr char WIDTH[] = "width";
@@ -47,105 +56,946 @@ constexpr char STOP_NAME[] = "stop_name";
 constexpr char TIME[] = "time";
 constexpr char BUS_KEY[] = "bus";
 constexpr char SPAN_COUNT[] = "span_count"; 
+constexpr char NEAREST_STOPS[] = "NearestStops";
+constexpr char STOPS_IN_BOX[] = "StopsInBox";
+constexpr char COUNT[] = "count";
+constexpr char RADIUS[] = "radius";
+constexpr char DISTANCE[] = "distance";
+constexpr char MIN_LATITUDE[] = "min_latitude";
+constexpr char MIN_LONGITUDE[] = "min_longitude";
+constexpr char MAX_LATITUDE[] = "max_latitude";
+constexpr char MAX_LONGITUDE[] = "max_longitude";
+constexpr char SUGGEST[] = "Suggest";
+constexpr char QUERY[] = "query";
+constexpr char KIND[] = "kind";
+constexpr char TYPOS[] = "typos";
+constexpr char NETWORK_STATS[] = "NetworkStats";
+constexpr char TOTAL_STOP_COUNT[] = "total_stop_count";
+constexpr char SERVED_STOP_COUNT[] = "served_stop_count";
+constexpr char BUS_COUNT[] = "bus_count";
+constexpr char TOTAL_ROUTE_LENGTH[] = "total_route_length";
+constexpr char TOTAL_GEO_DISTANCE[] = "total_geo_distance";
+constexpr char BUSIEST_STOPS[] = "busiest_stops";
+constexpr char MOST_CURVED_BUSES[] = "most_curved_buses";
+constexpr int DEFAULT_TOP_COUNT = 10;
+constexpr char MEMORY_STATS[] = "MemoryStats";
+constexpr char TOTAL_BYTES[] = "total_bytes";
+constexpr char TOTAL_ALLOCATIONS[] = "total_allocations";
+constexpr char COMPONENTS[] = "components";
+constexpr char BYTES[] = "bytes";
+constexpr char ALLOCATIONS[] = "allocations";
+constexpr char DISTANCE_TYPE[] = "Distance";
+constexpr char ACTION[] = "action";
+constexpr char ACTION_REMOVE[] = "remove";
+
+constexpr char BASE_REQUESTS[] = "base_requests";
 
 const std::string NOT_FOUND = "not found";
+const std::string UNKNOWN_REQUEST_TYPE = "unknown request type";
+
+namespace {
+
+using namespace std::literals;
+
+enum class RequestType { Unknown, Stop, Bus, Distance, Map, Route, NearestStops, StopsInBox, Suggest, NetworkStats, MemoryStats };
+
+// Имена типов запросов раскладываются по ячейкам при компиляции, поэтому выбор
+// обработчика стоит одного поиска в таблице вместо сравнения с каждым именем
+constexpr auto REQUEST_TYPES = perfect_hash::MakeStaticPerfectHash<RequestType>({
+    {STOP, RequestType::Stop},
+    {BUS, RequestType::Bus},
+    {DISTANCE_TYPE, RequestType::Distance},
+    {MAP, RequestType::Map},
+    {ROUTE, RequestType::Route},
+    {NEAREST_STOPS, RequestType::NearestStops},
+    {STOPS_IN_BOX, RequestType::StopsInBox},
+    {SUGGEST, RequestType::Suggest},
+    {NETWORK_STATS, RequestType::NetworkStats},
+    {MEMORY_STATS, RequestType::MemoryStats},
+});
+
+RequestType GetRequestType(std::string_view type) {
+    return REQUEST_TYPES.Find(type).value_or(RequestType::Unknown);
+}
+
+// Переносит элементы from в конец to
+template <typename T>
+void AppendMoved(std::vector<T>& to, std::vector<T>& from) {
+    if (to.empty()) {
+        to = std::move(from);
+        return;
+    }
+    to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+}
+
+// Обработчик потокового разбора входного документа. Глубина вложенности:
+// 1 — корень, 2 — массив base_requests, 3 — запрос, 4 — road_distances или stops
+class DocumentStreamHandler final : public json::SaxHandler {
+public:
+    DocumentStreamHandler(transport::catalogue::TransportCatalogue& catalogue,
+                          const std::vector<std::string_view>& skipped_sections)
+        : catalogue_(catalogue), skipped_sections_(skipped_sections) {
+    }
+
+    void Null() override {
+        if (!Forward(Nesting::Scalar, [](json::SaxHandler& handler) { handler.Null(); })) {
+            Scalar("null"sv);
+        }
+    }
+
+    void Bool(bool value) override {
+        if (Forward(Nesting::Scalar, [value](json::SaxHandler& handler) { handler.Bool(value); })) {
+            return;
+        }
+        if (depth_ == 3 && field_ == Field::IsRoundtrip) {
+            record_.is_roundtrip = value;
+        } else {
+            Scalar("bool"sv);
+        }
+    }
+
+    void Int(int value) override {
+        if (Forward(Nesting::Scalar, [value](json::SaxHandler& handler) { handler.Int(value); })) {
+            return;
+        }
+        if (depth_ == 4 && field_ == Field::RoadDistances) {
+            record_.distances.emplace_back(std::move(distance_to_), value);
+        } else {
+            Number(value);
+        }
+    }
+
+    void Double(double value) override {
+        if (!Forward(Nesting::Scalar, [value](json::SaxHandler& handler) { handler.Double(value); })) {
+            Number(value);
+        }
+    }
+
+    void String(std::string_view value) override {
+        if (Forward(Nesting::Scalar, [value](json::SaxHandler& handler) { handler.String(value); })) {
+            return;
+        }
+        if (depth_ == 3 && field_ == Field::Type) {
+            record_.type = GetRequestType(value);
+        } else if (depth_ == 3 && field_ == Field::Name) {
+            record_.name = value;
+        } else if (depth_ == 4 && field_ == Field::Stops) {
+            record_.stops.emplace_back(value);
+        } else {
+            Scalar("string"sv);
+        }
+    }
+
+    void StartDict() override {
+        if (Forward(Nesting::Open, [](json::SaxHandler& handler) { handler.StartDict(); })) {
+            return;
+        }
+        if (depth_ == 0 || (depth_ == 2) || (depth_ == 3 && field_ == Field::RoadDistances)) {
+            ++depth_;
+            if (depth_ == 3) {
+                record_ = {};
+            }
+        } else {
+            Skip();
+        }
+    }
+
+    void Key(std::string_view key) override {
+        if (Forward(Nesting::Scalar, [key](json::SaxHandler& handler) { handler.Key(key); })) {
+            return;
+        }
+        if (depth_ == 1) {
+            const bool skipped = std::find(skipped_sections_.begin(), skipped_sections_.end(), key)
+                != skipped_sections_.end();
+            if (key == BASE_REQUESTS && !skipped) {
+                field_ = Field::None;
+            } else {
+                // Остальные разделы корня собираются деревом, пропускаемые только проверяются
+                subtree_.emplace();
+                subtree_depth_ = 0;
+                subtree_key_ = key;
+                skip_subtree_ = skipped;
+            }
+        } else if (depth_ == 3) {
+            key_ = key;
+            field_ = ClassifyField(key);
+            CheckUniqueKey(key);
+        } else if (depth_ == 4) {
+            distance_to_ = key;
+        }
+    }
+
+    void EndDict() override {
+        if (Forward(Nesting::Close, [](json::SaxHandler& handler) { handler.EndDict(); })) {
+            return;
+        }
+        if (depth_ == 3) {
+            FlushRecord();
+        }
+        --depth_;
+    }
+
+    void StartArray() override {
+        if (Forward(Nesting::Open, [](json::SaxHandler& handler) { handler.StartArray(); })) {
+            return;
+        }
+        if (depth_ == 1 || (depth_ == 3 && field_ == Field::Stops)) {
+            ++depth_;
+        } else {
+            Skip();
+        }
+    }
+
+    void EndArray() override {
+        if (!Forward(Nesting::Close, [](json::SaxHandler& handler) { handler.EndArray(); })) {
+            --depth_;
+        }
+    }
+
+    // Загружает отложенные маршруты и расстояния и возвращает остальные разделы корня
+    json::Dict Finish() {
+        catalogue_.BulkLoad(std::move(deferred_));
+        return std::move(rest_);
+    }
+
+private:
+    enum class Field { None, Type, Name, Latitude, Longitude, RoadDistances, Stops, IsRoundtrip, Other };
+
+    static constexpr auto FIELDS = perfect_hash::MakeStaticPerfectHash<Field>({
+        {TYPE, Field::Type},
+        {NAME, Field::Name},
+        {LATITUDE, Field::Latitude},
+        {LONGITUDE, Field::Longitude},
+        {ROAD_DISTANCES, Field::RoadDistances},
+        {STOPS, Field::Stops},
+        {IS_ROUNDTRIP, Field::IsRoundtrip},
+    });
+
+    struct Record {
+        RequestType type = RequestType::Unknown;
+        std::optional<std::string> name;
+        std::optional<double> latitude;
+        std::optional<double> longitude;
+        std::optional<bool> is_roundtrip;
+        std::vector<std::pair<std::string, int>> distances;
+        std::vector<std::string> stops;
+        // Встреченные поля: известные — битами Field, прочие — именами
+        uint32_t seen_fields = 0;
+        std::vector<std::string> other_keys;
+    };
+
+    static Field ClassifyField(std::string_view key) {
+        return FIELDS.Find(key).value_or(Field::Other);
+    }
+
+    // Как событие меняет вложенность: ключ и скалярные значения её не меняют
+    enum class Nesting { Scalar, Open, Close };
+
+    // Передаёт событие в пропускаемое значение или в собираемый деревом раздел корня.
+    // Возвращает false, если событие относится к base_requests
+    template <typename Event>
+    bool Forward(Nesting nesting, Event event) {
+        const int shift = nesting == Nesting::Open ? 1 : nesting == Nesting::Close ? -1 : 0;
+        if (skip_depth_ > 0) {
+            skip_depth_ += shift;
+            return true;
+        }
+        if (!subtree_) {
+            return false;
+        }
+        if (!skip_subtree_) {
+            event(*subtree_);
+        }
+        subtree_depth_ += shift;
+        if (subtree_depth_ == 0) {
+            CompleteSubtree();
+        }
+        return true;
+    }
+
+    void CompleteSubtree() {
+        if (!skip_subtree_) {
+            rest_.emplace(std::move(subtree_key_), subtree_->ExtractRoot());
+        }
+        subtree_.reset();
+    }
+
+    void Number(double value) {
+        if (depth_ == 3 && field_ == Field::Latitude) {
+            record_.latitude = value;
+        } else if (depth_ == 3 && field_ == Field::Longitude) {
+            record_.longitude = value;
+        } else {
+            Scalar("number"sv);
+        }
+    }
+
+    void Scalar(std::string_view kind) {
+        if (depth_ == 3 && field_ == Field::Other) {
+            return;
+        }
+        if (depth_ <= 1) {
+            throw json::ParsingError("Input document must be a dictionary"s);
+        }
+        throw json::ParsingError("Unexpected "s + std::string(kind) + " for key '"s + key_ + "' in base_requests"s);
+    }
+
+    void Skip() {
+        if (depth_ == 3 && field_ == Field::Other) {
+            skip_depth_ = 1;
+            return;
+        }
+        Scalar(depth_ == 2 ? "value"sv : "container"sv);
+    }
+
+    template <typename T>
+    static T& Require(std::optional<T>& value, std::string_view key) {
+        if (!value) {
+            throw std::out_of_range("Missing '"s + std::string(key) + "' in base_requests"s);
+        }
+        return *value;
+    }
+
+    // Запрос читается без дерева, поэтому повтор ключа, который дерево отвергло бы
+    // при разборе, проверяется здесь
+    static void ThrowDuplicateKey(std::string_view key) {
+        throw json::ParsingError("Duplicate key '"s + std::string(key) + "' have been found"s);
+    }
+
+    void CheckUniqueKey(std::string_view key) {
+        if (field_ != Field::Other) {
+            const uint32_t bit = 1u << static_cast<int>(field_);
+            if (record_.seen_fields & bit) {
+                ThrowDuplicateKey(key);
+            }
+            record_.seen_fields |= bit;
+            return;
+        }
+        auto& keys = record_.other_keys;
+        if (std::find(keys.begin(), keys.end(), key) != keys.end()) {
+            ThrowDuplicateKey(key);
+        }
+        keys.emplace_back(key);
+    }
+
+    void CheckUniqueDistances() const {
+        std::vector<std::string_view> stops;
+        stops.reserve(record_.distances.size());
+        for (const auto& [to, _] : record_.distances) {
+            stops.push_back(to);
+        }
+        std::sort(stops.begin(), stops.end());
+        if (auto duplicate = std::adjacent_find(stops.begin(), stops.end()); duplicate != stops.end()) {
+            ThrowDuplicateKey(*duplicate);
+        }
+    }
+
+    void FlushRecord() {
+        if (record_.type == RequestType::Stop) {
+            const std::string& name = Require(record_.name, NAME);
+            CheckUniqueDistances();
+            catalogue_.AddStop(name, {Require(record_.latitude, LATITUDE), Require(record_.longitude, LONGITUDE)});
+            for (auto& [to, distance] : record_.distances) {
+                deferred_.distances.push_back({name, std::move(to), static_cast<double>(distance)});
+            }
+        } else if (record_.type == RequestType::Bus) {
+            deferred_.buses.push_back({std::move(Require(record_.name, NAME)), std::move(record_.stops),
+                                       Require(record_.is_roundtrip, IS_ROUNDTRIP)});
+        }
+    }
+
+    transport::catalogue::TransportCatalogue& catalogue_;
+    const std::vector<std::string_view>& skipped_sections_;
+    transport::catalogue::CatalogueInput deferred_;
+    json::Dict rest_;
+
+    int depth_ = 0;
+    Field field_ = Field::None;
+    std::string key_;
+    std::string distance_to_;
+    Record record_;
+
+    std::optional<json::DomBuilder> subtree_;
+    std::string subtree_key_;
+    int subtree_depth_ = 0;
+    bool skip_subtree_ = false;
+    int skip_depth_ = 0;
+};
+
+// Разбор массива stat_requests из событий: каждый запрос собирается в ленивый
+// документ request и передаётся on_request, как только закрыт. Глубина
+// вложенности: 0 — вне массива, 1 — сам массив, дальше — запрос
+template <typename OnRequest>
+class StatRequestsHandler final : public json::SaxHandler {
+public:
+    StatRequestsHandler(json::LazyDocument& request, json::SaxHandler& output, OnRequest on_request)
+        : builder_(request), output_(output), on_request_(std::move(on_request)) {
+    }
+
+    void Null() override {
+        Forward(0, [](json::SaxHandler& handler) { handler.Null(); });
+    }
+
+    void Bool(bool value) override {
+        Forward(0, [value](json::SaxHandler& handler) { handler.Bool(value); });
+    }
+
+    void Int(int value) override {
+        Forward(0, [value](json::SaxHandler& handler) { handler.Int(value); });
+    }
+
+    void Double(double value) override {
+        Forward(0, [value](json::SaxHandler& handler) { handler.Double(value); });
+    }
+
+    void String(std::string_view value) override {
+        Forward(0, [value](json::SaxHandler& handler) { handler.String(value); });
+    }
+
+    void StartDict() override {
+        Forward(1, [](json::SaxHandler& handler) { handler.StartDict(); });
+    }
+
+    void Key(std::string_view key) override {
+        Forward(0, [key](json::SaxHandler& handler) { handler.Key(key); });
+    }
+
+    void EndDict() override {
+        Forward(-1, [](json::SaxHandler& handler) { handler.EndDict(); });
+    }
+
+    void StartArray() override {
+        if (depth_ == 0) {
+            depth_ = 1;
+            output_.StartArray();
+        } else {
+            Forward(1, [](json::SaxHandler& handler) { handler.StartArray(); });
+        }
+    }
+
+    void EndArray() override {
+        if (depth_ == 1) {
+            depth_ = 0;
+            output_.EndArray();
+        } else {
+            Forward(-1, [](json::SaxHandler& handler) { handler.EndArray(); });
+        }
+    }
+
+private:
+    // Передаёт событие запросу; shift — изменение вложенности
+    template <typename Event>
+    void Forward(int shift, Event event) {
+        if (depth_ == 0) {
+            throw json::ParsingError("Array is expected"s);
+        }
+        event(builder_);
+        depth_ += shift;
+        if (depth_ == 1) {
+            on_request_();
+            builder_.Reset();
+        }
+    }
+
+    json::LazyDocument::Builder builder_;
+    json::SaxHandler& output_;
+    OnRequest on_request_;
+    int depth_ = 0;
+};
+
+using transport::catalogue::BusInput;
+using transport::catalogue::DistanceInput;
+
+// Запрос на добавление остановки: сама остановка и расстояния от неё
+struct StopRecord {
+    transport::catalogue::StopInput stop;
+    std::vector<DistanceInput> distances;
+};
+
+// Начальная остановка расстояний заполняется после чтения имени
+void ReadRoadDistances(const json::LazyNode& node, std::vector<DistanceInput>& distances) {
+    distances.reserve(node.size());
+    node.ForEachMember([&distances](std::string_view to, const json::LazyNode& distance) {
+        distances.push_back({{}, std::string(to), static_cast<double>(distance.AsInt())});
+    });
+    std::vector<std::string_view> stops;
+    stops.reserve(distances.size());
+    for (const auto& distance : distances) {
+        stops.push_back(distance.to);
+    }
+    std::sort(stops.begin(), stops.end());
+    if (auto duplicate = std::adjacent_find(stops.begin(), stops.end()); duplicate != stops.end()) {
+        throw json::ParsingError("Duplicate key '"s + std::string(*duplicate) + "' have been found"s);
+    }
+}
+
+void ReadColor(const json::LazyNode& node, svg::Color& color) {
+    if (node.IsString()) {
+        color = node.AsString();
+        return;
+    }
+    if (node.IsArray() && (node.size() == 3 || node.size() == 4)) {
+        auto component = node.begin();
+        const auto next_byte = [&component] {
+            const auto value = static_cast<uint8_t>((*component).AsInt());
+            ++component;
+            return value;
+        };
+        const uint8_t red = next_byte();
+        const uint8_t green = next_byte();
+        const uint8_t blue = next_byte();
+        if (node.size() == 3) {
+            color = svg::Rgb{red, green, blue};
+        } else {
+            color = svg::Rgba{red, green, blue, (*component).AsDouble()};
+        }
+        return;
+    }
+    color = svg::NoneColor;
+}
+
+void ReadPalette(const json::LazyNode& node, std::vector<svg::Color>& palette) {
+    palette.clear();
+    palette.reserve(node.size());
+    for (const json::LazyNode color : node) {
+        ReadColor(color, palette.emplace_back());
+    }
+}
+
+void ReadOffset(const json::LazyNode& node, svg::Point& offset) {
+    if (node.size() < 2) {
+        throw std::out_of_range("Offset must have two coordinates"s);
+    }
+    auto coordinate = node.begin();
+    offset.x = (*coordinate).AsDouble();
+    ++coordinate;
+    offset.y = (*coordinate).AsDouble();
+}
+
+// Время ожидания задаётся целым числом минут
+void ReadWaitTime(const json::LazyNode& node, double& wait_time) {
+    wait_time = node.AsInt();
+}
+
+constexpr auto STOP_SCHEMA = json::MakeSchema<StopRecord>(
+    json::Field(NAME, [](StopRecord& record) -> std::string& { return record.stop.name; }),
+    json::Field(LATITUDE, [](StopRecord& record) -> double& { return record.stop.coords.lat; }),
+    json::Field(LONGITUDE, [](StopRecord& record) -> double& { return record.stop.coords.lng; }),
+    json::OptionalField(ROAD_DISTANCES, &StopRecord::distances, ReadRoadDistances));
+
+constexpr auto BUS_SCHEMA = json::MakeSchema<BusInput>(
+    json::Field(NAME, &BusInput::name),
+    json::Field(STOPS, &BusInput::stops),
+    json::Field(IS_ROUNDTRIP, &BusInput::isRoundTrip));
+
+constexpr auto RENDER_SETTINGS_SCHEMA = json::MakeSchema<renderer::RenderSettings>(
+    json::Field(WIDTH, &renderer::RenderSettings::width),
+    json::Field(HEIGHT, &renderer::RenderSettings::height),
+    json::Field(PADDING, &renderer::RenderSettings::padding),
+    json::Field(LINE_WIDTH, &renderer::RenderSettings::line_width),
+    json::Field(STOP_RADIUS, &renderer::RenderSettings::stop_radius),
+    json::Field(BUS_LABEL_FONT_SIZE, &renderer::RenderSettings::bus_label_font_size),
+    json::Field(BUS_LABEL_OFFSET, &renderer::RenderSettings::bus_label_offset, ReadOffset),
+    json::Field(STOP_LABEL_FONT_SIZE, &renderer::RenderSettings::stop_label_font_size),
+    json::Field(STOP_LABEL_OFFSET, &renderer::RenderSettings::stop_label_offset, ReadOffset),
+    json::Field(UNDERLAYER_COLOR, &renderer::RenderSettings::underlayer_color, ReadColor),
+    json::Field(UNDERLAYER_WIDTH, &renderer::RenderSettings::underlayer_width),
+    json::Field(COLOR_PALETTE, &renderer::RenderSettings::color_palette, ReadPalette));
+
+constexpr auto ROUTING_SETTINGS_SCHEMA = json::MakeSchema<transport::RoutingSettings>(
+    json::Field(BUS_VELOCITY, &transport::RoutingSettings::bus_velocity),
+    json::Field(BUS_WAIT_TIME, &transport::RoutingSettings::bus_wait_time, ReadWaitTime));
+
+// Запрос base_requests из ленивого документа: значения читаются схемами прямо
+// в структуры справочника, имена переносятся в его хранилище без копий
+void ReadBaseRequest(const json::LazyNode& request, transport::catalogue::CatalogueInput& input) {
+    switch (GetRequestType(request.at(TYPE).AsString())) {
+        case RequestType::Stop: {
+            StopRecord record = STOP_SCHEMA.Read(request);
+            for (auto& distance : record.distances) {
+                distance.from = record.stop.name;
+            }
+            AppendMoved(input.distances, record.distances);
+            input.stops.push_back(std::move(record.stop));
+            break;
+        }
+        case RequestType::Bus:
+            input.buses.push_back(BUS_SCHEMA.Read(request));
+            break;
+        default:
+            break;
+    }
+}
+
+}  // namespace
 
 void JSONReader::ProcessBaseRequests(const json::Array& base_requests) {
+    transport::catalogue::CatalogueInput input;
 
     for(const auto& request_node : base_requests) {
+        ProcessBaseRequest(request_node.AsDict(), input);
+    }
+
+    catalogue_.BulkLoad(std::move(input));
+    stop_index_.reset();
+    map_cache_.reset();
+}
+
+void JSONReader::ProcessBaseRequestsParallel(std::string_view base_requests) {
+    using transport::catalogue::CatalogueInput;
+
+    const std::vector<std::string_view> items = json::SplitArray(base_requests);
+    CatalogueInput input = parallel::ChunkedReduce(items.size(), CatalogueInput{},
+        [this, &items](size_t begin, size_t end) {
+            CatalogueInput part;
+            json::LazyDocument request;
+            for (size_t i = begin; i < end; ++i) {
+                request.Load(items[i]);
+                ReadBaseRequest(request.GetRoot(), part);
+            }
+            return part;
+        },
+        [](CatalogueInput& input, CatalogueInput&& part) {
+            AppendMoved(input.stops, part.stops);
+            AppendMoved(input.distances, part.distances);
+            AppendMoved(input.buses, part.buses);
+        });
+
+    catalogue_.BulkLoad(std::move(input));
+    stop_index_.reset();
+    map_cache_.reset();
+}
+
+json::Dict JSONReader::ProcessDocumentStream(std::string_view input,
+                                             const std::vector<std::string_view>& skipped_sections) {
+    DocumentStreamHandler handler(catalogue_, skipped_sections);
+    json::Parse(input, handler);
+    json::Dict rest = handler.Finish();
+    stop_index_.reset();
+    map_cache_.reset();
+    return rest;
+}
+
+json::Dict JSONReader::ProcessCborDocumentStream(std::string_view input,
+                                                 const std::vector<std::string_view>& skipped_sections) {
+    DocumentStreamHandler handler(catalogue_, skipped_sections);
+    cbor::Parse(input, handler);
+    json::Dict rest = handler.Finish();
+    stop_index_.reset();
+    map_cache_.reset();
+    return rest;
+}
+
+transport::catalogue::CatalogueChanges JSONReader::ApplyDeltaRequests(const json::Array& delta_requests) {
+    LoadAttachedImage();
+    transport::catalogue::CatalogueInput upserts;
+    transport::catalogue::CatalogueDelta delta;
+
+    // Добавление и изменение равнозначны: объект с тем же именем заменяется
+    for (const auto& request_node : delta_requests) {
         const json::Dict& request = request_node.AsDict();
-        std::string type = request.at(json_reader::TYPE).AsString();
+        const RequestType type = GetRequestType(request.at(json_reader::TYPE).AsString());
+        // Действие либо не указано (добавление или замена), либо remove. Ошибка
+        // обнаруживается до применения, поэтому дельта не применяется частично
+        bool remove = false;
+        if (request.count(json_reader::ACTION)) {
+            const std::string_view action = request.at(json_reader::ACTION).AsStringView();
+            if (action != json_reader::ACTION_REMOVE) {
+                throw std::invalid_argument("Unknown action '"s + std::string(action) + "' in delta_requests"s);
+            }
+            remove = true;
+        }
 
-        if(type == json_reader::STOP) {
-            ProcessStopRequest(request);
+        switch (type) {
+            case RequestType::Stop:
+                if (remove) {
+                    delta.removedStops.push_back(request.at(json_reader::NAME).AsString());
+                } else {
+                    ProcessStopRequest(request, upserts);
+                }
+                break;
+            case RequestType::Bus:
+                if (remove) {
+                    delta.removedBuses.push_back(request.at(json_reader::NAME).AsString());
+                } else {
+                    ProcessBusRequest(request, upserts);
+                }
+                break;
+            case RequestType::Distance: {
+                const std::string& from = request.at(json_reader::FROM).AsString();
+                const std::string& to = request.at(json_reader::TO).AsString();
+                if (remove) {
+                    delta.removedDistances.emplace_back(from, to);
+                } else {
+                    upserts.distances.push_back({from, to, static_cast<double>(request.at(json_reader::DISTANCE).AsInt())});
+                }
+                break;
+            }
+            default:
+                break;
         }
     }
+    delta.stops = std::move(upserts.stops);
+    delta.distances = std::move(upserts.distances);
+    delta.buses = std::move(upserts.buses);
 
-    SetAllPendingDistances();
-    
-    for (const auto& request_node : base_requests) {
-        const json::Dict& request = request_node.AsDict();
-        std::string type = request.at(json_reader::TYPE).AsString();
+    if (snapshots_) {
+        return PublishDelta(delta);
+    }
+    auto changes = catalogue_.ApplyDelta(delta);
+    if (snapshot_ || changes.IsEmpty()) {
+        // Запросы обслуживает закреплённая версия, её структуры не меняются
+        return changes;
+    }
 
-        if (type == json_reader::BUS) {
-            ProcessBusRequest(request);
-        }
+    if (changes.HasStopChanges()) {
+        stop_index_.reset();
+    }
+    if (map_cache_ && map_cache_->renderer->IsAffectedBy(catalogue_, changes)) {
+        map_cache_.reset();
+    }
+    if (router_ && router_->IsAffectedBy(changes) && !router_->ApplyChanges(changes)) {
+        SetRouter(*routing_settings_);
+    }
+    return changes;
+}
+
+transport::catalogue::CatalogueChanges JSONReader::PublishDelta(const transport::catalogue::CatalogueDelta& delta) {
+    // Следующая версия готовится на копии, закреплённая версия не меняется
+    auto next = std::make_unique<transport::catalogue::TransportCatalogue>(*snapshot_);
+    auto changes = next->ApplyDelta(delta);
+    snapshots_->Publish(std::move(next));
+    // Прежняя версия удаляется, когда её отпустят и читатель, и маршрутизатор
+    snapshot_ = snapshots_->Acquire();
+
+    // Пространственный индекс ссылается на остановки прежней версии
+    stop_index_.reset();
+    if (map_cache_ && map_cache_->renderer->IsAffectedBy(*snapshot_, changes)) {
+        map_cache_.reset();
+    }
+    // Граф переносится на новую версию по именам остановок и дополняется новыми
+    // маршрутами; если перенести или дополнить его нельзя, он строится заново
+    if (router_ && (!router_->Rebind(snapshot_)
+                    || (router_->IsAffectedBy(changes) && !router_->ApplyChanges(changes)))) {
+        SetRouter(*routing_settings_);
     }
+    return changes;
 }
 
-void JSONReader::ProcessStopRequest(const json::Dict& request) {
-    std::string name = request.at(json_reader::NAME).AsString();
+void JSONReader::EnableSnapshots() {
+    if (snapshots_) {
+        return;
+    }
+    LoadAttachedImage();
+    // Справочник переносится в первую версию без копирования: остановки остаются
+    // на своих адресах, и маршрутизатор переходит на неё без перестроения
+    snapshots_ = std::make_unique<transport::catalogue::CatalogueSnapshots>(
+        std::make_unique<transport::catalogue::TransportCatalogue>(std::move(catalogue_)));
+    snapshot_ = snapshots_->Acquire();
+    if (router_ && !router_->Rebind(snapshot_)) {
+        SetRouter(*routing_settings_);
+    }
+}
+
+void JSONReader::ProcessBaseRequest(const json::Dict& request, transport::catalogue::CatalogueInput& input) {
+    switch (GetRequestType(request.at(json_reader::TYPE).AsString())) {
+        case RequestType::Stop:
+            ProcessStopRequest(request, input);
+            break;
+        case RequestType::Bus:
+            ProcessBusRequest(request, input);
+            break;
+        default:
+            break;
+    }
+}
+
+void JSONReader::ProcessStopRequest(const json::Dict& request, transport::catalogue::CatalogueInput& input) {
+    const std::string& name = request.at(json_reader::NAME).AsString();
     double latitude = request.at(json_reader::LATITUDE).AsDouble();
     double longitude = request.at(json_reader::LONGITUDE).AsDouble();
 
     geo::Coordinates coords = { latitude, longitude };
-    catalogue_.AddStop(name, coords);
+    input.stops.push_back({name, coords});
     if(request.count(json_reader::ROAD_DISTANCES)) {
         const auto& distances = request.at(json_reader::ROAD_DISTANCES).AsDict();
         for(const auto& [stop_name, distance] : distances) {
-            pending_distances_.emplace_back(name, stop_name, distance.AsInt());
+            input.distances.push_back({name, stop_name, static_cast<double>(distance.AsInt())});
         }
     }
 }
 
-void JSONReader::ProcessBusRequest(const json::Dict& request) {
-    std::string name = request.at(json_reader::NAME).AsString();
+void JSONReader::ProcessBusRequest(const json::Dict& request, transport::catalogue::CatalogueInput& input) {
     const json::Array& stop_names = request.at(json_reader::STOPS).AsArray();
-    std::vector<std::string> stops;
+    transport::catalogue::BusInput bus;
+    bus.name = request.at(json_reader::NAME).AsString();
+    bus.stops.reserve(stop_names.size());
 
     for (const auto& stop_name : stop_names) {
-        stops.push_back(stop_name.AsString());
+        bus.stops.push_back(stop_name.AsString());
     }
 
-    bool is_roundtrip = request.at(json_reader::IS_ROUNDTRIP).AsBool();
-    catalogue_.AddBus(name, stops, is_roundtrip);
+    bus.isRoundTrip = request.at(json_reader::IS_ROUNDTRIP).AsBool();
+    input.buses.push_back(std::move(bus));
 }
 
-void JSONReader::SetAllPendingDistances() {
-    for (const auto& [from, to, dist] : pending_distances_) {
-        const auto* from_stop = catalogue_.FindStop(from);
-        const auto* to_stop = catalogue_.FindStop(to);
-        if (from_stop && to_stop) {
-            catalogue_.SetDistanceBetweenStops(from_stop, to_stop, dist);
-        }
+void JSONReader::ProcessStatRequestsStream(std::string_view stat_requests, const renderer::MapRenderer& renderer,
+                                           std::ostream& output, json::PrintOptions print_options) {
+    json::Writer writer(output, print_options);
+    json::SaxPrinter printer(writer);
+    ProcessStatRequestsStream(stat_requests, renderer, printer);
+}
+
+void JSONReader::ProcessStatRequestsStream(std::string_view stat_requests, const renderer::MapRenderer& renderer,
+                                           json::SaxHandler& output) {
+    json::ArrayReader requests(stat_requests);
+    // Лента одного запроса переиспользуется, значения раскодируются только при чтении обработчиком
+    json::LazyDocument request;
+
+    output.StartArray();
+    while (requests.Next(request)) {
+        HandleStatRequest(request.GetRoot(), renderer, output);
     }
+    output.EndArray();
 }
 
-json::Array JSONReader::ProcessStatRequests(const json::Array& stat_requests, const renderer::MapRenderer& renderer) {
-    json::Array responses;
+void JSONReader::ProcessCborStatRequestsStream(std::string_view stat_requests, const renderer::MapRenderer& renderer,
+                                               json::SaxHandler& output) {
+    // События каждого запроса записываются прямо на ленту ленивого документа,
+    // поэтому обработчики те же, что для текста JSON, а текст не строится
+    json::LazyDocument request;
+    StatRequestsHandler handler(request, output, [this, &request, &renderer, &output] {
+        HandleStatRequest(request.GetRoot(), renderer, output);
+    });
+    cbor::Parse(stat_requests, handler);
+}
 
-    for(const auto& stat_request : stat_requests) {
-        const json::Dict& request = stat_request.AsDict();
-        int request_id = request.at(json_reader::ID).AsInt();
-        std::string type = request.at(json_reader::TYPE).AsString();
-        json::Dict response;
-        response[json_reader::REQUEST_ID] = request_id;
+void JSONReader::ServeStatRequests(std::istream& input, const renderer::MapRenderer& renderer,
+                                   std::ostream& output, json::PrintOptions print_options) {
+    // Ответ обязан занимать одну строку
+    print_options.compact = true;
+    json::LazyDocument request;
+    std::string line;
+    std::ostringstream response;
 
-        if(type == json_reader::STOP) {
-            responses.emplace_back(HandleStopRequest(request));
-        } else if (type == json_reader::BUS) {
-            responses.emplace_back(HandleBusRequest(request));
-        } else if (type == json_reader::MAP) {
-            responses.emplace_back(HandleMapRequest(request, renderer));
-        } else if (type == json_reader::ROUTE) {
-            responses.emplace_back(HandleRouteRequest(request));
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        // Ответ копится отдельно, чтобы ошибка посреди него не испортила вывод
+        response.str({});
+        std::optional<int> request_id;
+        std::string error;
+        try {
+            json::Writer writer(response, print_options);
+            json::SaxPrinter printer(writer);
+            request.Load(line);
+            const json::LazyNode root = request.GetRoot();
+            if (root.IsDict() && root.count(ID) && root.at(ID).IsInt()) {
+                request_id = root.at(ID).AsInt();
+            }
+            if (root.IsDict() && root.count(DELTA_REQUESTS)) {
+                EnableSnapshots();
+                const auto changes = ApplyDeltaRequests(root.at(DELTA_REQUESTS).Materialize().AsArray());
+                json::StreamBuilder builder(printer);
+                auto dict = builder.StartDict();
+                if (request_id) {
+                    dict.Key(REQUEST_ID).Value(*request_id);
+                }
+                dict.Key(VERSION).Value(static_cast<int>(changes.version)).EndDict();
+            } else if (!HandleStatRequest(root, renderer, printer)) {
+                error = UNKNOWN_REQUEST_TYPE;
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        if (!error.empty()) {
+            response.str({});
+            json::Writer writer(response, print_options);
+            json::SaxPrinter printer(writer);
+            BuildErrorLine(request_id, error, printer);
+        }
+        output << response.str() << '\n';
+        // Пока во входе есть прочитанные строки, ответы копятся в буфере потока
+        // и уходят пачкой; перед ожиданием новой строки вывод сбрасывается
+        if (input.rdbuf()->in_avail() <= 0) {
+            output.flush();
         }
     }
+    output.flush();
+}
 
-    return responses;
+void JSONReader::BuildErrorLine(std::optional<int> request_id, const std::string& message,
+                                json::SaxHandler& output) const {
+    json::StreamBuilder builder(output);
+    auto dict = builder.StartDict();
+    if (request_id) {
+        dict.Key(REQUEST_ID).Value(*request_id);
+    }
+    dict.Key(ERROR_MESSAGE).Value(message).EndDict();
 }
 
-json::Dict JSONReader::HandleStopRequest(const json::Dict& request) {
-    std::string_view stop_name = request.at(json_reader::NAME).AsString();
-    const auto* stop = catalogue_.FindStop(stop_name);
+bool JSONReader::HandleStatRequest(const json::LazyNode& request, const renderer::MapRenderer& renderer,
+                                   json::SaxHandler& output) {
+    // Построитель ничего не выводит, пока обработчик не начал ответ
+    json::StreamBuilder builder(output);
+    const RequestType type = GetRequestType(request.at(json_reader::TYPE).AsString());
+    if (pending_image_) {
+        if (type == RequestType::Stop) {
+            HandleImageStopRequest(request, builder);
+            return true;
+        }
+        if (type == RequestType::Bus) {
+            HandleImageBusRequest(request, builder);
+            return true;
+        }
+        if (type != RequestType::Unknown) {
+            LoadAttachedImage();
+        }
+    }
+    switch (type) {
+        case RequestType::Stop:
+            HandleStopRequest(request, builder);
+            return true;
+        case RequestType::Bus:
+            HandleBusRequest(request, builder);
+            return true;
+        case RequestType::Map:
+            HandleMapRequest(request, renderer, builder);
+            return true;
+        case RequestType::Route:
+            HandleRouteRequest(request, builder);
+            return true;
+        case RequestType::NearestStops:
+            HandleNearestStopsRequest(request, builder);
+            return true;
+        case RequestType::StopsInBox:
+            HandleStopsInBoxRequest(request, builder);
+            return true;
+        case RequestType::Suggest:
+            HandleSuggestRequest(request, builder);
+            return true;
+        case RequestType::NetworkStats:
+            HandleNetworkStatsRequest(request, builder);
+            return true;
+        case RequestType::MemoryStats:
+            HandleMemoryStatsRequest(request, renderer, builder);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void JSONReader::HandleStopRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    const std::string stop_name = request.at(json_reader::NAME).AsString();
+    const auto* stop = GetCatalogue().FindStop(stop_name);
 
     if (!stop) {
-        return json::Builder{}.StartDict()
+        builder.StartDict()
             .Key(REQUEST_ID).Value(request.at(ID).AsInt())
             .Key(ERROR_MESSAGE).Value(NOT_FOUND)
-        .EndDict().Build().AsDict();
+        .EndDict();
     } else {
-        json::Builder builder;
         auto array_ctx = builder.StartDict()
             .Key(REQUEST_ID).Value(request.at(ID).AsInt())
             .Key(BUSES).StartArray();
@@ -154,138 +1004,206 @@ json::Dict JSONReader::HandleStopRequest(const json::Dict& request) {
             array_ctx.Value(bus);
         }
 
-        return array_ctx.EndArray().EndDict().Build().AsDict();
+        array_ctx.EndArray().EndDict();
     }
 
 }
 
-json::Dict JSONReader::HandleBusRequest(const json::Dict& request) {
-    std::string_view bus_name = request.at(json_reader::NAME).AsString();
-    const transport::catalogue::Bus* bus = catalogue_.FindBus(bus_name);
+namespace {
+
+// Извилистость маршрута нулевой длины не определена: после удаления остановок
+// дельтой маршрут может сойтись в точку, и поле тогда опускается, как в NetworkStats
+void BuildBusInfoAnswer(int request_id, const transport::catalogue::BusInfo& bus_info,
+                        json::StreamBuilder& builder) {
+    auto dict = builder.StartDict().Key(REQUEST_ID).Value(request_id);
+    if (bus_info.geoDistance > 0) {
+        dict.Key(CURVATURE).Value(bus_info.routeLength / bus_info.geoDistance);
+    }
+    dict.Key(ROUTE_LENGTH).Value(bus_info.routeLength)
+        .Key(STOP_COUNT).Value(bus_info.stopsCount)
+        .Key(UNIQUE_STOP_COUNT).Value(bus_info.uniqueStops)
+    .EndDict();
+}
+
+}  // namespace
+
+void JSONReader::HandleBusRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    const std::string name = request.at(json_reader::NAME).AsString();
+    std::string_view bus_name = name;
+    const transport::catalogue::Bus* bus = GetCatalogue().FindBus(bus_name);
 
    if (!bus) {
-        return json::Builder{}.StartDict()
+        builder.StartDict()
             .Key(REQUEST_ID).Value(request.at(ID).AsInt())
             .Key(ERROR_MESSAGE).Value(NOT_FOUND)
-        .EndDict().Build().AsDict();
+        .EndDict();
+        return;
     }
 
-    transport::catalogue::BusInfo bus_info = catalogue_.GetBusInfo(bus_name);
-    return json::Builder{}.StartDict()
-        .Key(REQUEST_ID).Value(request.at(ID).AsInt())
-        .Key(CURVATURE).Value(bus_info.routeLength / bus_info.geoDistance)
-        .Key(ROUTE_LENGTH).Value(bus_info.routeLength)
-        .Key(STOP_COUNT).Value(bus_info.stopsCount)
-        .Key(UNIQUE_STOP_COUNT).Value(bus_info.uniqueStops)
-    .EndDict().Build().AsDict();
+    BuildBusInfoAnswer(request.at(ID).AsInt(), GetCatalogue().GetBusInfo(bus_name), builder);
+}
+
+void JSONReader::HandleImageStopRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    const auto stop = pending_image_->FindStop(request.at(json_reader::NAME).AsString());
 
+    if (!stop) {
+        builder.StartDict()
+            .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+            .Key(ERROR_MESSAGE).Value(NOT_FOUND)
+        .EndDict();
+        return;
+    }
+
+    auto array_ctx = builder.StartDict()
+        .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+        .Key(BUSES).StartArray();
+    for (const std::string_view bus : pending_image_->GetBusesByStop(*stop)) {
+        array_ctx.Value(bus);
+    }
+    array_ctx.EndArray().EndDict();
 }
 
-json::Dict JSONReader::HandleMapRequest(const json::Dict& request, const renderer::MapRenderer& renderer) {
-    std::ostringstream svg_stream;
-    renderer.RenderMap(catalogue_).Render(svg_stream);
-    return json::Builder{}.StartDict()
+void JSONReader::HandleImageBusRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    const auto bus = pending_image_->FindBus(request.at(json_reader::NAME).AsString());
+
+    if (!bus) {
+        builder.StartDict()
             .Key(REQUEST_ID).Value(request.at(ID).AsInt())
-            .Key(MAP_KEY).Value(svg_stream.str())
-        .EndDict().Build().AsDict();
+            .Key(ERROR_MESSAGE).Value(NOT_FOUND)
+        .EndDict();
+        return;
+    }
+
+    BuildBusInfoAnswer(request.at(ID).AsInt(), pending_image_->GetBusInfo(*bus), builder);
 }
 
-renderer::RenderSettings JSONReader::ParseRenderSettings(const json::Dict& dict) {
-    renderer::RenderSettings settings;
-    settings.width = dict.at(json_reader::WIDTH).AsDouble();
-    settings.height = dict.at(json_reader::HEIGHT).AsDouble();
-    settings.padding = dict.at(json_reader::PADDING).AsDouble();
-    settings.line_width = dict.at(json_reader::LINE_WIDTH).AsDouble();
-    settings.stop_radius = dict.at(json_reader::STOP_RADIUS).AsDouble();
-    settings.bus_label_font_size = dict.at(json_reader::BUS_LABEL_FONT_SIZE).AsInt();
-    settings.bus_label_offset = ParseOffset(dict.at(json_reader::BUS_LABEL_OFFSET).AsArray());
-    settings.stop_label_font_size = dict.at(json_reader::STOP_LABEL_FONT_SIZE).AsInt();
-    settings.stop_label_offset = ParseOffset(dict.at(json_reader::STOP_LABEL_OFFSET).AsArray());
-    settings.underlayer_color = ParseColor(dict.at(json_reader::UNDERLAYER_COLOR));
-    settings.underlayer_width = dict.at(json_reader::UNDERLAYER_WIDTH).AsDouble();
-    const auto& palette = dict.at(json_reader::COLOR_PALETTE).AsArray();
-    for (const auto& color : palette) {
-        settings.color_palette.push_back(ParseColor(color));
+void JSONReader::HandleMapRequest(const json::LazyNode& request, const renderer::MapRenderer& renderer,
+                                 json::StreamBuilder& builder) {
+    if (!map_cache_ || map_cache_->renderer != &renderer) {
+        std::ostringstream svg_stream;
+        renderer.RenderMap(GetCatalogue()).Render(svg_stream);
+        map_cache_ = MapCache{&renderer, svg_stream.str()};
     }
+    builder.StartDict()
+            .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+            .Key(MAP_KEY).Value(map_cache_->svg)
+        .EndDict();
+}
 
-    return settings;
+renderer::RenderSettings JSONReader::ParseRenderSettings(const json::LazyNode& node) {
+    return RENDER_SETTINGS_SCHEMA.Read(node);
 }
 
-transport::RoutingSettings JSONReader::ParseRoutingSettings(const json::Dict& dict) {
-    transport::RoutingSettings settings;
-    settings.bus_velocity = dict.at(json_reader::BUS_VELOCITY).AsDouble();
-    settings.bus_wait_time = dict.at(json_reader::BUS_WAIT_TIME).AsInt();
-    return settings;
+transport::RoutingSettings JSONReader::ParseRoutingSettings(const json::LazyNode& node) {
+    return ROUTING_SETTINGS_SCHEMA.Read(node);
 }
 
 void JSONReader::SetRouter(transport::RoutingSettings settings) {
-    router_ = std::make_unique<transport::TransportRouter>(catalogue_, settings);
+    routing_settings_ = settings;
+    if (pending_image_) {
+        // Маршрутизатор строится после переноса образа в справочник
+        return;
+    }
+    if (snapshot_) {
+        router_ = std::make_unique<transport::TransportRouter>(snapshot_, settings);
+    } else {
+        router_ = std::make_unique<transport::TransportRouter>(catalogue_, settings);
+    }
 }
 
-svg::Color JSONReader::ParseColor(const json::Node& node) {
-    if (node.IsString()) {
-        return node.AsString();
-    } else if (node.IsArray()) {
-        const auto& arr = node.AsArray();
-        if (arr.size() == 3) {
-            return svg::Rgb{
-                static_cast<uint8_t>(arr[0].AsInt()),
-                static_cast<uint8_t>(arr[1].AsInt()),
-                static_cast<uint8_t>(arr[2].AsInt())
-            };
-        } else if (arr.size() == 4) {
-            return svg::Rgba{
-                static_cast<uint8_t>(arr[0].AsInt()),
-                static_cast<uint8_t>(arr[1].AsInt()),
-                static_cast<uint8_t>(arr[2].AsInt()),
-                arr[3].AsDouble()
-            };
-        }
+void JSONReader::AttachImage(const transport::catalogue::CatalogueImage& image) {
+    pending_image_ = &image;
+}
+
+void JSONReader::LoadAttachedImage() {
+    if (!pending_image_) {
+        return;
+    }
+    pending_image_->LoadInto(catalogue_);
+    pending_image_ = nullptr;
+    catalogue_.Freeze();
+    stop_index_.reset();
+    map_cache_.reset();
+    if (routing_settings_) {
+        SetRouter(*routing_settings_);
     }
-    
-    return svg::NoneColor;
 }
 
-svg::Point JSONReader::ParseOffset(const json::Array& arr) {
-    return { arr[0].AsDouble(), arr[1].AsDouble() };
+void JSONReader::BindSnapshot(transport::catalogue::CatalogueSnapshots::Snapshot snapshot) {
+    snapshot_ = std::move(snapshot);
+    stop_index_.reset();
+    map_cache_.reset();
+    if (routing_settings_) {
+        SetRouter(*routing_settings_);
+    }
 }
 
-json::Dict JSONReader::HandleRouteRequest(const json::Dict& request) {
+memory::MemoryReport JSONReader::CollectMemoryUsage(const renderer::MapRenderer& renderer) const {
+    memory::MemoryReport report;
+    GetCatalogue().CollectMemoryUsage(report);
+    if (router_) {
+        router_->CollectMemoryUsage(report);
+    }
+    renderer.CollectMemoryUsage(report);
+    if (map_cache_) {
+        report.push_back({"renderer.map_cache", memory::ContainerUsage(map_cache_->svg)});
+    }
+    if (stop_index_) {
+        report.push_back({"spatial_index", stop_index_->GetMemoryUsage()});
+    }
+    return report;
+}
+
+const transport::catalogue::TransportCatalogue& JSONReader::GetCatalogue() const {
+    return snapshot_ ? *snapshot_ : catalogue_;
+}
+
+const transport::StopSpatialIndex& JSONReader::GetStopIndex() {
+    if (!stop_index_) {
+        stop_index_ = std::make_unique<transport::StopSpatialIndex>(GetCatalogue());
+    }
+    return *stop_index_;
+}
+
+void JSONReader::HandleRouteRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
     const int request_id = request.at(ID).AsInt();
     const std::string& from = request.at(FROM).AsString();
     const std::string& to = request.at(TO).AsString();
 
     if (!request.count(FROM) || !request.count(TO)) {
-        return BuildRouteErrorResponse(request_id);
+        BuildRouteErrorResponse(request_id, builder);
+        return;
     }
 
     if (!router_) {
-        return BuildRouteErrorResponse(request_id);
+        BuildRouteErrorResponse(request_id, builder);
+        return;
     }
 
     auto route = router_->BuildRoute(from, to);
     if (!route) {
-        return BuildRouteErrorResponse(request_id);
+        BuildRouteErrorResponse(request_id, builder);
+        return;
     }
 
-    return BuildRouteResponse(request_id, *route);
+    BuildRouteResponse(request_id, *route, builder);
 }
 
-json::Dict JSONReader::BuildRouteErrorResponse(int request_id) const {
-    return json::Builder{}
+void JSONReader::BuildRouteErrorResponse(int request_id, json::StreamBuilder& builder) const {
+    builder
         .StartDict()
         .Key(REQUEST_ID).Value(request_id)
         .Key(ERROR_MESSAGE).Value(NOT_FOUND)
-        .EndDict().Build().AsDict();
+        .EndDict();
 }
 
-json::Dict JSONReader::BuildRouteResponse(int request_id, const std::vector<transport::RouteItem>& route) const {
+void JSONReader::BuildRouteResponse(int request_id, const std::vector<transport::RouteItem>& route,
+                                    json::StreamBuilder& builder) const {
     double total_time = 0.0;
     for (const auto& item : route) {
         total_time += item.time;
     }
 
-    json::Builder builder;
     auto dict = builder.StartDict();
     dict.Key(REQUEST_ID).Value(request_id);
     dict.Key(TOTAL_TIME).Value(total_time);
@@ -295,10 +1213,10 @@ json::Dict JSONReader::BuildRouteResponse(int request_id, const std::vector<tran
         AppendRouteItem(array, item);
     }
 
-    return array.EndArray().EndDict().Build().AsDict();
+    array.EndArray().EndDict();
 }
 
-void JSONReader::AppendRouteItem(json::ArrayItemContext& array, const transport::RouteItem& item) const {
+void JSONReader::AppendRouteItem(json::StreamArrayItemContext& array, const transport::RouteItem& item) const {
     auto obj = array.StartDict();
     if (item.type == transport::RouteItem::Type::Wait) {
         obj.Key(TYPE).Value(WAIT)
@@ -313,4 +1231,160 @@ void JSONReader::AppendRouteItem(json::ArrayItemContext& array, const transport:
     obj.EndDict();
 }
 
+void JSONReader::HandleNearestStopsRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    const geo::Coordinates center{request.at(LATITUDE).AsDouble(), request.at(LONGITUDE).AsDouble()};
+    const int count = request.at(COUNT).AsInt();
+    const double radius = request.count(RADIUS)
+        ? request.at(RADIUS).AsDouble()
+        : std::numeric_limits<double>::infinity();
+
+    const auto nearest = GetStopIndex().FindNearest(center, count > 0 ? count : 0, radius);
+
+    auto array = builder.StartDict()
+        .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+        .Key(STOPS).StartArray();
+
+    for (const auto& [stop, distance] : nearest) {
+        array.StartDict()
+            .Key(NAME).Value(stop->name)
+            .Key(DISTANCE).Value(distance)
+        .EndDict();
+    }
+
+    array.EndArray().EndDict();
+}
+
+void JSONReader::HandleStopsInBoxRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    const geo::Coordinates min{request.at(MIN_LATITUDE).AsDouble(), request.at(MIN_LONGITUDE).AsDouble()};
+    const geo::Coordinates max{request.at(MAX_LATITUDE).AsDouble(), request.at(MAX_LONGITUDE).AsDouble()};
+
+    auto stops = GetStopIndex().FindInBox(min, max);
+    std::sort(stops.begin(), stops.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->name < rhs->name;
+    });
+
+    auto array = builder.StartDict()
+        .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+        .Key(STOPS).StartArray();
+
+    for (const auto* stop : stops) {
+        array.Value(stop->name);
+    }
+
+    array.EndArray().EndDict();
+}
+
+void JSONReader::HandleSuggestRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    using transport::catalogue::NameKind;
+
+    const std::string& query = request.at(QUERY).AsString();
+    const int count = request.at(COUNT).AsInt();
+    std::optional<NameKind> kind;
+    if (request.count(KIND)) {
+        const std::string& kind_name = request.at(KIND).AsString();
+        if (kind_name == STOP) {
+            kind = NameKind::Stop;
+        } else if (kind_name == BUS) {
+            kind = NameKind::Bus;
+        }
+    }
+
+    const auto suggestions = GetCatalogue().Suggest(query, count > 0 ? count : 0, kind);
+
+    auto array = builder.StartDict()
+        .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+        .Key(ITEMS).StartArray();
+
+    for (const auto& suggestion : suggestions) {
+        array.StartDict()
+            .Key(NAME).Value(std::string(suggestion.name))
+            .Key(TYPE).Value(suggestion.kind == NameKind::Stop ? STOP : BUS)
+            .Key(TYPOS).Value(suggestion.typos)
+        .EndDict();
+    }
+
+    array.EndArray().EndDict();
+}
+
+void JSONReader::HandleNetworkStatsRequest(const json::LazyNode& request, json::StreamBuilder& builder) {
+    const int count = request.count(COUNT) ? request.at(COUNT).AsInt() : DEFAULT_TOP_COUNT;
+    const auto stats = GetCatalogue().GetNetworkStats(count > 0 ? count : 0);
+
+    auto dict = builder.StartDict()
+        .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+        .Key(TOTAL_STOP_COUNT).Value(static_cast<int>(stats.stopCount))
+        .Key(SERVED_STOP_COUNT).Value(static_cast<int>(stats.servedStopCount))
+        .Key(BUS_COUNT).Value(static_cast<int>(stats.busCount))
+        .Key(TOTAL_ROUTE_LENGTH).Value(stats.totalRouteLength)
+        .Key(TOTAL_GEO_DISTANCE).Value(stats.totalGeoDistance);
+
+    auto busiest = dict.Key(BUSIEST_STOPS).StartArray();
+    for (const auto& load : stats.busiestStops) {
+        busiest.StartDict()
+            .Key(NAME).Value(load.stop->name)
+            .Key(BUS_COUNT).Value(static_cast<int>(load.busCount))
+        .EndDict();
+    }
+    busiest.EndArray();
+
+    auto curved = dict.Key(MOST_CURVED_BUSES).StartArray();
+    for (const auto& bus : stats.mostCurvedBuses) {
+        curved.StartDict()
+            .Key(NAME).Value(bus.bus->name)
+            .Key(CURVATURE).Value(bus.info.routeLength / bus.info.geoDistance)
+        .EndDict();
+    }
+    curved.EndArray();
+
+    auto buses = dict.Key(BUSES).StartArray();
+    for (const auto& bus : stats.buses) {
+        auto item = buses.StartDict().Key(NAME).Value(bus.bus->name);
+        // Извилистость маршрута нулевой длины не определена, поле опускается
+        if (bus.info.geoDistance > 0) {
+            item.Key(CURVATURE).Value(bus.info.routeLength / bus.info.geoDistance);
+        }
+        item.Key(ROUTE_LENGTH).Value(bus.info.routeLength)
+            .Key(STOP_COUNT).Value(bus.info.stopsCount)
+            .Key(UNIQUE_STOP_COUNT).Value(bus.info.uniqueStops)
+        .EndDict();
+    }
+    buses.EndArray();
+
+    dict.EndDict();
+}
+
+namespace {
+
+// Байты выводятся целым числом, пока помещаются в int; иначе вещественным
+json::Node SizeToNode(size_t value) {
+    if (value <= static_cast<size_t>(std::numeric_limits<int>::max())) {
+        return static_cast<int>(value);
+    }
+    return static_cast<double>(value);
+}
+
+}  // namespace
+
+void JSONReader::HandleMemoryStatsRequest(const json::LazyNode& request, const renderer::MapRenderer& renderer,
+                                         json::StreamBuilder& builder) {
+    const auto report = CollectMemoryUsage(renderer);
+    const auto total = memory::GetTotal(report);
+
+    auto components = builder.StartDict()
+        .Key(REQUEST_ID).Value(request.at(ID).AsInt())
+        .Key(TOTAL_BYTES).Value(SizeToNode(total.bytes))
+        .Key(TOTAL_ALLOCATIONS).Value(SizeToNode(total.allocations))
+        .Key(COMPONENTS).StartArray();
+
+    for (const auto& component : report) {
+        components.StartDict()
+            .Key(NAME).Value(component.name)
+            .Key(BYTES).Value(SizeToNode(component.usage.bytes))
+            .Key(ALLOCATIONS).Value(SizeToNode(component.usage.allocations))
+        .EndDict();
+    }
+
+    components.EndArray().EndDict();
+}
+
 }  // namespace json_reader
\ No newline at end of file
@@ -3,52 +3,125 @@
 #include "json.h"
 #include "map_renderer.h"
 #include "transport_catalogue.h"
+#include "catalogue_snapshot.h"
+#include "catalogue_image.h"
 #include "request_handler.h"
 #include "json_builder.h"
+#include "json_stream_builder.h"
 #include "transport_router.h"
+#include "spatial_index.h"
 
 namespace json_reader {
 
-struct PendingDistance {
-    std::string from;
-    std::string to;
-    int distance;
-
-    PendingDistance(std::string from, std::string to, int distance)
-        : from(std::move(from)), to(std::move(to)), distance(distance) {}
-};
-
 class JSONReader {
 public:
     JSONReader(transport::catalogue::TransportCatalogue& catalogue)
     : catalogue_(catalogue) {};
 
     void ProcessBaseRequests(const json::Array& base_requests);
-    json::Array ProcessStatRequests(const json::Array& stat_requests, const renderer::MapRenderer& renderer);
-    renderer::RenderSettings ParseRenderSettings(const json::Dict& dict);
-    transport::RoutingSettings ParseRoutingSettings(const json::Dict& dict);
+    // Разбор base_requests из текста массива в несколько потоков: границы элементов
+    // находятся предварительным проходом, каждый поток разбирает свою непрерывную часть
+    // в собственные списки, и списки склеиваются в исходном порядке
+    void ProcessBaseRequestsParallel(std::string_view base_requests);
+    // Потоковый разбор входного документа без построения дерева для base_requests:
+    // остановки попадают в справочник по мере разбора, ссылки маршрутов на остановки
+    // и расстояния разрешаются после конца потока. Остальные разделы корня
+    // возвращаются деревом, кроме перечисленных в skipped_sections: те только проверяются
+    json::Dict ProcessDocumentStream(std::string_view input,
+                                     const std::vector<std::string_view>& skipped_sections = {});
+    // То же для входного документа в формате CBOR
+    json::Dict ProcessCborDocumentStream(std::string_view input,
+                                         const std::vector<std::string_view>& skipped_sections = {});
+    // Применяет запросы на добавление, изменение и удаление объектов к действующему
+    // справочнику и обновляет только затронутые производные структуры
+    transport::catalogue::CatalogueChanges ApplyDeltaRequests(const json::Array& delta_requests);
+    // Потоковая обработка: запросы из текста массива stat_requests разбираются по одному,
+    // ответ на каждый сразу пишется в output. Память не зависит от числа запросов
+    void ProcessStatRequestsStream(std::string_view stat_requests, const renderer::MapRenderer& renderer,
+                                   std::ostream& output, json::PrintOptions print_options = {});
+    void ProcessStatRequestsStream(std::string_view stat_requests, const renderer::MapRenderer& renderer,
+                                   json::SaxHandler& output);
+    // То же для массива stat_requests в формате CBOR
+    void ProcessCborStatRequestsStream(std::string_view stat_requests, const renderer::MapRenderer& renderer,
+                                       json::SaxHandler& output);
+    // Долгоживущий режим JSON Lines: каждая непустая строка input — один stat-запрос,
+    // ответ на него пишется в output одной строкой. Неизвестный тип или ошибка в
+    // запросе дают строку с error_message и не прерывают работу до конца input.
+    // Строка со словарём delta_requests публикует новую версию справочника (см.
+    // EnableSnapshots), ответ на неё — номер версии: маршрутизатор дополняется новыми
+    // маршрутами без перестроения, карта отрисовывается заново при следующем запросе Map
+    void ServeStatRequests(std::istream& input, const renderer::MapRenderer& renderer,
+                           std::ostream& output, json::PrintOptions print_options = {});
+    // Настройки читаются схемами прямо из текста раздела, без построения дерева
+    renderer::RenderSettings ParseRenderSettings(const json::LazyNode& node);
+    transport::RoutingSettings ParseRoutingSettings(const json::LazyNode& node);
     void SetRouter(transport::RoutingSettings settings);
+    // Справочник из отображённого образа: запросы Stop и Bus обслуживаются прямо
+    // со страниц образа, а обычный справочник заполняется из него только перед первым
+    // запросом, которому нужны указатели на Stop и Bus. Образ должен пережить JSONReader
+    void AttachImage(const transport::catalogue::CatalogueImage& image);
+    // Заполняет справочник из подключённого образа, если это ещё не сделано
+    void LoadAttachedImage();
+    // Переводит справочник в режим версий: он переносится в первую версию хранилища,
+    // stat-запросы обслуживает закреплённая версия, а каждая дельта применяется к копии
+    // и публикуется следующей версией. Запросы, закрепившие прежнюю версию, дорабатывают
+    // с ней; она удаляется, когда её отпустит последний снимок. catalogue_ после этого
+    // не используется
+    void EnableSnapshots();
+    // Привязывает stat-запросы и маршрутизатор к закреплённой версии справочника
+    void BindSnapshot(transport::catalogue::CatalogueSnapshots::Snapshot snapshot);
+    // Память справочника, маршрутизатора, отрисовщика и кешей запросов по компонентам
+    memory::MemoryReport CollectMemoryUsage(const renderer::MapRenderer& renderer) const;
 
 private:
-    void ProcessStopRequest(const json::Dict& request);
-    void ProcessBusRequest(const json::Dict& request);
-    void SetAllPendingDistances();
+    void ProcessBaseRequest(const json::Dict& request, transport::catalogue::CatalogueInput& input);
+    void ProcessStopRequest(const json::Dict& request, transport::catalogue::CatalogueInput& input);
+    void ProcessBusRequest(const json::Dict& request, transport::catalogue::CatalogueInput& input);
+    transport::catalogue::CatalogueChanges PublishDelta(const transport::catalogue::CatalogueDelta& delta);
 
-    json::Dict HandleStopRequest(const json::Dict& request);
-    json::Dict HandleBusRequest(const json::Dict& request);
-    json::Dict HandleMapRequest(const json::Dict& request, const renderer::MapRenderer& renderer);
-    json::Dict HandleRouteRequest(const json::Dict& request);
+    // Передаёт ответ на запрос в output; false, если тип запроса неизвестен и ответа нет
+    bool HandleStatRequest(const json::LazyNode& request, const renderer::MapRenderer& renderer,
+                           json::SaxHandler& output);
+    void HandleStopRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleBusRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleImageStopRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleImageBusRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleMapRequest(const json::LazyNode& request, const renderer::MapRenderer& renderer,
+                          json::StreamBuilder& builder);
+    void HandleRouteRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleNearestStopsRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleStopsInBoxRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleSuggestRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleNetworkStatsRequest(const json::LazyNode& request, json::StreamBuilder& builder);
+    void HandleMemoryStatsRequest(const json::LazyNode& request, const renderer::MapRenderer& renderer,
+                                  json::StreamBuilder& builder);
+    const transport::StopSpatialIndex& GetStopIndex();
 
-    svg::Color ParseColor(const json::Node& node);
-    svg::Point ParseOffset(const json::Array& arr);
+    const transport::catalogue::TransportCatalogue& GetCatalogue() const;
 
-    json::Dict BuildRouteErrorResponse(int request_id) const;
-    json::Dict BuildRouteResponse(int request_id, const std::vector<transport::RouteItem>& route) const;
-    void AppendRouteItem(json::ArrayItemContext& array, const transport::RouteItem& item) const;
+    void BuildErrorLine(std::optional<int> request_id, const std::string& message,
+                        json::SaxHandler& output) const;
+    void BuildRouteErrorResponse(int request_id, json::StreamBuilder& builder) const;
+    void BuildRouteResponse(int request_id, const std::vector<transport::RouteItem>& route,
+                            json::StreamBuilder& builder) const;
+    void AppendRouteItem(json::StreamArrayItemContext& array, const transport::RouteItem& item) const;
 
     transport::catalogue::TransportCatalogue& catalogue_;
-    std::vector<PendingDistance> pending_distances_;
     std::unique_ptr<transport::TransportRouter> router_;
+    std::optional<transport::RoutingSettings> routing_settings_;
+    // Хранилище версий в режиме EnableSnapshots; snapshot_ — закреплённая текущая версия
+    std::unique_ptr<transport::catalogue::CatalogueSnapshots> snapshots_;
+    transport::catalogue::CatalogueSnapshots::Snapshot snapshot_;
+    std::unique_ptr<transport::StopSpatialIndex> stop_index_;
+    // Образ, ещё не перенесённый в catalogue_
+    const transport::catalogue::CatalogueImage* pending_image_ = nullptr;
+
+    // Последняя отрисованная карта; сбрасывается, только если дельта её меняет
+    struct MapCache {
+        const renderer::MapRenderer* renderer = nullptr;
+        std::string svg;
+    };
+    std::optional<MapCache> map_cache_;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "json.h"
+#include "perfect_hash.h"
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+// Чтение значения ленивого документа в переменную по её типу
+struct ValueReader {
+    void operator()(const LazyNode& node, bool& out) const {
+        out = node.AsBool();
+    }
+
+    void operator()(const LazyNode& node, int& out) const {
+        out = node.AsInt();
+    }
+
+    void operator()(const LazyNode& node, double& out) const {
+        out = node.AsDouble();
+    }
+
+    void operator()(const LazyNode& node, std::string& out) const {
+        out = node.AsString();
+    }
+
+    template <typename T>
+    void operator()(const LazyNode& node, std::vector<T>& out) const {
+        out.clear();
+        out.reserve(node.size());
+        for (const LazyNode item : node) {
+            (*this)(item, out.emplace_back());
+        }
+    }
+};
+
+// Поле схемы: ключ словаря, доступ к члену структуры — указатель на член или функция,
+// возвращающая ссылку, — и функция чтения значения в этот член
+template <typename Accessor, typename Reader>
+struct SchemaField {
+    std::string_view key;
+    Accessor accessor;
+    Reader reader;
+    bool required;
+
+    template <typename Struct>
+    void Read(const LazyNode& value, Struct& out) const {
+        reader(value, std::invoke(accessor, out));
+    }
+};
+
+template <typename Accessor, typename Reader = ValueReader>
+constexpr SchemaField<Accessor, Reader> Field(std::string_view key, Accessor accessor, Reader reader = {}) {
+    return {key, accessor, reader, true};
+}
+
+// Поле, которого может не быть в словаре: член структуры тогда не меняется
+template <typename Accessor, typename Reader = ValueReader>
+constexpr SchemaField<Accessor, Reader> OptionalField(std::string_view key, Accessor accessor, Reader reader = {}) {
+    return {key, accessor, reader, false};
+}
+
+// Декларативное описание словаря: из какого ключа в какой член структуры читается
+// значение. Словарь обходится один раз, поле по ключу находится совершенным хешем,
+// построенным при компиляции, значения читаются прямо с ленты документа без Node.
+// Незнакомые ключи пропускаются, повтор известного ключа — ошибка разбора, как в Load
+template <typename Struct, typename... Fields>
+class Schema {
+public:
+    static_assert(sizeof...(Fields) <= 64, "Seen fields are tracked in a 64-bit mask");
+
+    constexpr explicit Schema(Fields... fields)
+        : fields_(fields...)
+        , index_(MakeIndex(fields_, std::index_sequence_for<Fields...>{})) {
+    }
+
+    void Read(const LazyNode& node, Struct& out) const {
+        uint64_t seen = 0;
+        node.ForEachMember([&](std::string_view key, const LazyNode& value) {
+            const auto field = index_.Find(key);
+            if (!field) {
+                return;
+            }
+            if (seen >> *field & 1) {
+                throw ParsingError("Duplicate key '" + std::string(key) + "' have been found");
+            }
+            seen |= uint64_t{1} << *field;
+            ReadField(*field, value, out, std::index_sequence_for<Fields...>{});
+        });
+        CheckRequired(seen, std::index_sequence_for<Fields...>{});
+    }
+
+    Struct Read(const LazyNode& node) const {
+        Struct out{};
+        Read(node, out);
+        return out;
+    }
+
+private:
+    using Index = perfect_hash::StaticPerfectHash<size_t, sizeof...(Fields)>;
+
+    template <size_t... I>
+    static constexpr Index MakeIndex(const std::tuple<Fields...>& fields, std::index_sequence<I...>) {
+        const typename Index::Item items[] = {{std::get<I>(fields).key, I}...};
+        return Index(items);
+    }
+
+    template <size_t... I>
+    void ReadField(size_t field, const LazyNode& value, Struct& out, std::index_sequence<I...>) const {
+        ((field == I ? std::get<I>(fields_).Read(value, out) : void()), ...);
+    }
+
+    template <size_t... I>
+    void CheckRequired(uint64_t seen, std::index_sequence<I...>) const {
+        (CheckField(std::get<I>(fields_), (seen >> I & 1) != 0), ...);
+    }
+
+    template <typename Field>
+    static void CheckField(const Field& field, bool seen) {
+        if (field.required && !seen) {
+            throw std::out_of_range("Missing '" + std::string(field.key) + "'");
+        }
+    }
+
+    std::tuple<Fields...> fields_;
+    Index index_;
+};
+
+template <typename Struct, typename... Fields>
+constexpr Schema<Struct, Fields...> MakeSchema(Fields... fields) {
+    return Schema<Struct, Fields...>(fields...);
+}
+
+}  // namespace json
\ No newline at end of file
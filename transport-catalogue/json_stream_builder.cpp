@@ -0,0 +1,172 @@
+#include "json_stream_builder.h"
+
+namespace json {
+
+StreamKeyValueContext::StreamKeyValueContext(StreamBuilder& builder)
+    : builder_(builder) {}
+
+StreamDictItemContext StreamKeyValueContext::StartDict() {
+    builder_.StartDict();
+    return StreamDictItemContext(builder_);
+}
+
+StreamArrayItemContext StreamKeyValueContext::StartArray() {
+    builder_.StartArray();
+    return StreamArrayItemContext(builder_);
+}
+
+
+StreamDictItemContext::StreamDictItemContext(StreamBuilder& builder)
+    : builder_(builder) {}
+
+StreamKeyValueContext StreamDictItemContext::Key(std::string_view key) {
+    builder_.Key(key);
+    return StreamKeyValueContext(builder_);
+}
+
+StreamBuilder& StreamDictItemContext::EndDict() {
+    return builder_.EndDict();
+}
+
+
+StreamArrayItemContext::StreamArrayItemContext(StreamBuilder& builder)
+    : builder_(builder) {}
+
+StreamDictItemContext StreamArrayItemContext::StartDict() {
+    builder_.StartDict();
+    return StreamDictItemContext(builder_);
+}
+
+StreamArrayItemContext StreamArrayItemContext::StartArray() {
+    builder_.StartArray();
+    return *this;
+}
+
+StreamBuilder& StreamArrayItemContext::EndArray() {
+    return builder_.EndArray();
+}
+
+
+StreamBuilder::StreamBuilder(SaxHandler& output)
+    : output_(output) {}
+
+StreamKeyValueContext StreamBuilder::Key(std::string_view key) {
+    if (stack_.empty() || !stack_.back() || key_pending_) {
+        throw std::logic_error("Key outside of dictionary");
+    }
+    output_.Key(key);
+    key_pending_ = true;
+    return StreamKeyValueContext(*this);
+}
+
+StreamBuilder& StreamBuilder::Value(const Node& value) {
+    BeginValue();
+    Emit(value, output_);
+    EndValue();
+    return *this;
+}
+
+StreamBuilder& StreamBuilder::Value(const std::string& value) {
+    return Value(std::string_view(value));
+}
+
+StreamBuilder& StreamBuilder::Value(std::string_view value) {
+    BeginValue();
+    output_.String(value);
+    EndValue();
+    return *this;
+}
+
+StreamBuilder& StreamBuilder::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+StreamBuilder& StreamBuilder::Value(int value) {
+    BeginValue();
+    output_.Int(value);
+    EndValue();
+    return *this;
+}
+
+StreamBuilder& StreamBuilder::Value(double value) {
+    BeginValue();
+    output_.Double(value);
+    EndValue();
+    return *this;
+}
+
+StreamBuilder& StreamBuilder::Value(bool value) {
+    BeginValue();
+    output_.Bool(value);
+    EndValue();
+    return *this;
+}
+
+StreamBuilder& StreamBuilder::Value(std::nullptr_t) {
+    BeginValue();
+    output_.Null();
+    EndValue();
+    return *this;
+}
+
+StreamDictItemContext StreamBuilder::StartDict() {
+    BeginValue();
+    output_.StartDict();
+    stack_.push_back(true);
+    return StreamDictItemContext(*this);
+}
+
+StreamBuilder& StreamBuilder::EndDict() {
+    if (stack_.empty() || !stack_.back() || key_pending_) {
+        throw std::logic_error("EndDict without StartDict");
+    }
+    stack_.pop_back();
+    output_.EndDict();
+    EndValue();
+    return *this;
+}
+
+StreamArrayItemContext StreamBuilder::StartArray() {
+    BeginValue();
+    output_.StartArray();
+    stack_.push_back(false);
+    return StreamArrayItemContext(*this);
+}
+
+StreamBuilder& StreamBuilder::EndArray() {
+    if (stack_.empty() || stack_.back()) {
+        throw std::logic_error("EndArray without StartArray");
+    }
+    stack_.pop_back();
+    output_.EndArray();
+    EndValue();
+    return *this;
+}
+
+bool StreamBuilder::IsComplete() const {
+    return complete_;
+}
+
+// Проверяет, что значение допустимо в текущем контексте
+void StreamBuilder::BeginValue() {
+    if (stack_.empty()) {
+        if (complete_) {
+            throw std::logic_error("Value after complete object");
+        }
+        return;
+    }
+    if (stack_.back()) {
+        if (!key_pending_) {
+            throw std::logic_error("Value in invalid context");
+        }
+        key_pending_ = false;
+    }
+}
+
+void StreamBuilder::EndValue() {
+    if (stack_.empty()) {
+        complete_ = true;
+    }
+}
+
+} // namespace json
\ No newline at end of file
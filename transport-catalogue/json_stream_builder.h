@@ -0,0 +1,108 @@
+#pragma once
+
+#include "json.h"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+class StreamBuilder;
+class StreamKeyValueContext;
+class StreamDictItemContext;
+class StreamArrayItemContext;
+
+// Контексты повторяют контексты Builder: недопустимая последовательность вызовов
+// не компилируется
+
+class StreamKeyValueContext {
+public:
+    StreamKeyValueContext(StreamBuilder& builder);
+
+    template <typename T>
+    StreamDictItemContext Value(T&& value);
+    StreamDictItemContext StartDict();
+    StreamArrayItemContext StartArray();
+
+private:
+    StreamBuilder& builder_;
+};
+
+class StreamDictItemContext {
+public:
+    StreamDictItemContext(StreamBuilder& builder);
+
+    StreamKeyValueContext Key(std::string_view key);
+    StreamBuilder& EndDict();
+
+private:
+    StreamBuilder& builder_;
+};
+
+class StreamArrayItemContext {
+public:
+    StreamArrayItemContext(StreamBuilder& builder);
+
+    template <typename T>
+    StreamArrayItemContext Value(T&& value);
+    StreamDictItemContext StartDict();
+    StreamArrayItemContext StartArray();
+    StreamBuilder& EndArray();
+
+private:
+    StreamBuilder& builder_;
+};
+
+// Построитель с интерфейсом Builder, который не собирает дерево, а сразу передаёт
+// значения приёмнику событий: SaxPrinter печатает их текстом, другие приёмники
+// кодируют иначе или собирают дерево. Ключи словаря передаются в порядке вызовов
+// Key, их уникальность не проверяется
+class StreamBuilder {
+public:
+    explicit StreamBuilder(SaxHandler& output);
+
+    StreamKeyValueContext Key(std::string_view key);
+
+    StreamBuilder& Value(const Node& value);
+    StreamBuilder& Value(const std::string& value);
+    StreamBuilder& Value(std::string_view value);
+    StreamBuilder& Value(const char* value);
+    StreamBuilder& Value(int value);
+    StreamBuilder& Value(double value);
+    StreamBuilder& Value(bool value);
+    StreamBuilder& Value(std::nullptr_t);
+
+    StreamDictItemContext StartDict();
+    StreamBuilder& EndDict();
+
+    StreamArrayItemContext StartArray();
+    StreamBuilder& EndArray();
+
+    // Значение верхнего уровня выведено полностью
+    bool IsComplete() const;
+
+private:
+    void BeginValue();
+    void EndValue();
+
+    SaxHandler& output_;
+    // Для каждого открытого контейнера: словарь ли это
+    std::vector<bool> stack_;
+    bool key_pending_ = false;
+    bool complete_ = false;
+};
+
+template <typename T>
+StreamDictItemContext StreamKeyValueContext::Value(T&& value) {
+    builder_.Value(std::forward<T>(value));
+    return StreamDictItemContext(builder_);
+}
+
+template <typename T>
+StreamArrayItemContext StreamArrayItemContext::Value(T&& value) {
+    builder_.Value(std::forward<T>(value));
+    return *this;
+}
+
+} // namespace json
\ No newline at end of file
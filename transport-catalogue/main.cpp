@@ -1,47 +1,302 @@
+#include <charconv>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "json.h"
+#include "cbor.h"
 #include "json_reader.h"
 #include "request_handler.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "catalogue_image.h"
 
 namespace json_fields {
     inline constexpr std::string_view BASE_REQUESTS = "base_requests";
+    inline constexpr std::string_view DELTA_REQUESTS = "delta_requests";
     inline constexpr std::string_view STAT_REQUESTS = "stat_requests";
     inline constexpr std::string_view RENDER_SETTINGS = "render_settings";
     inline constexpr std::string_view ROUTING_SETTINGS = "routing_settings";
 }
 
-int main() {
-    // Чтение JSON из stdin
-    std::string input_json;
-    std::getline(std::cin, input_json, '\0');
-    std::istringstream input_stream(input_json);
-    json::Document input_doc = json::Load(input_stream);
-    const json::Dict& root = input_doc.GetRoot().AsDict();;
+namespace {
+
+// Формат входного документа и ответов
+enum class Format {
+    Json,
+    Cbor,
+};
+
+// Параметры командной строки
+struct Options {
+    std::string save_image;  // --save-image <файл>: сохранить образ справочника после base_requests
+    std::string load_image;  // --load-image <файл>: взять справочник из образа вместо base_requests
+    std::string input;       // --input <файл>: читать запросы из файла, отображённого в память, а не из stdin
+    bool memory_stats = false;  // --memory-stats: вывести расход памяти по компонентам в stderr
+    json::PrintOptions print;   // --compact: ответы без пробелов; --precision <n>: значащих цифр, 0 — кратчайшая запись
+    bool parallel_parse = false;  // --parallel-parse: разбирать base_requests в несколько потоков
+    Format format = Format::Json;  // --format json|cbor: формат ввода и вывода
+    bool serve = false;  // --serve: после загрузки отвечать на запросы из stdin построчно
+};
+
+std::optional<Format> ParseFormat(std::string_view text) {
+    if (text == "json") {
+        return Format::Json;
+    }
+    if (text == "cbor") {
+        return Format::Cbor;
+    }
+    return std::nullopt;
+}
+
+std::optional<int> ParsePrecision(std::string_view text) {
+    int precision = 0;
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), precision);
+    if (ec != std::errc() || ptr != text.data() + text.size() || precision < 0) {
+        return std::nullopt;
+    }
+    return precision;
+}
+
+std::optional<Options> ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--save-image" && i + 1 < argc) {
+            options.save_image = argv[++i];
+        } else if (arg == "--load-image" && i + 1 < argc) {
+            options.load_image = argv[++i];
+        } else if (arg == "--input" && i + 1 < argc) {
+            options.input = argv[++i];
+        } else if (arg == "--memory-stats") {
+            options.memory_stats = true;
+        } else if (arg == "--serve") {
+            options.serve = true;
+        } else if (arg == "--parallel-parse") {
+            options.parallel_parse = true;
+        } else if (arg == "--compact") {
+            options.print.compact = true;
+        } else if (arg == "--precision" && i + 1 < argc) {
+            const auto precision = ParsePrecision(argv[++i]);
+            if (!precision) {
+                std::cerr << "Invalid precision: " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+            options.print.precision = *precision;
+        } else if (arg == "--format" && i + 1 < argc) {
+            const auto format = ParseFormat(argv[++i]);
+            if (!format) {
+                std::cerr << "Invalid format: " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+            options.format = *format;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return std::nullopt;
+        }
+    }
+    if (options.serve && options.format == Format::Cbor) {
+        std::cerr << "--serve reads requests as JSON Lines and does not support CBOR" << std::endl;
+        return std::nullopt;
+    }
+    return options;
+}
+
+// Входной JSON целиком в памяти: файл отображается без копирования,
+// stdin читается крупными блоками прямо в буфер
+class InputBuffer {
+public:
+    InputBuffer() {
+        constexpr size_t BLOCK_SIZE = 1 << 20;
+        size_t size = 0;
+        while (true) {
+            buffer_.resize(size + BLOCK_SIZE);
+            const size_t read = std::fread(buffer_.data() + size, 1, BLOCK_SIZE, stdin);
+            size += read;
+            if (read < BLOCK_SIZE) {
+                break;
+            }
+        }
+        buffer_.resize(size);
+        view_ = buffer_;
+    }
+
+    // Одна строка потока: в режиме --serve документ занимает первую строку stdin,
+    // а следующие строки — запросы
+    explicit InputBuffer(std::istream& input) {
+        std::getline(input, buffer_);
+        view_ = buffer_;
+    }
+
+    explicit InputBuffer(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open input " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat input " + path);
+        }
+        mapped_size_ = static_cast<size_t>(st.st_size);
+        if (mapped_size_ > 0) {
+            void* mapping = ::mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Failed to map input " + path);
+            }
+            mapping_ = mapping;
+            view_ = std::string_view(static_cast<const char*>(mapping), mapped_size_);
+        }
+        ::close(fd);
+    }
+
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+
+    ~InputBuffer() {
+        if (mapping_) {
+            ::munmap(mapping_, mapped_size_);
+        }
+    }
+
+    std::string_view GetView() const {
+        return view_;
+    }
+
+private:
+    std::string buffer_;
+    void* mapping_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::string_view view_;
+};
+
+void PrintMemoryReport(const memory::MemoryReport& report, std::ostream& out) {
+    for (const auto& component : report) {
+        out << component.name << ": " << component.usage.bytes << " bytes, "
+            << component.usage.allocations << " allocations" << std::endl;
+    }
+    const auto total = memory::GetTotal(report);
+    out << "total: " << total.bytes << " bytes, " << total.allocations << " allocations" << std::endl;
+}
+
+// Раздел корня документа в ленивом документе: текст JSON индексируется на месте,
+// события раздела CBOR записываются на ленту без перекодирования в текст
+void LoadSection(json::LazyDocument& document, std::string_view input, std::string_view key, bool cbor_format) {
+    const auto section = cbor_format ? cbor::FindMember(input, key) : json::FindMember(input, key);
+    if (!section) {
+        throw std::out_of_range("Missing " + std::string(key));
+    }
+    if (cbor_format) {
+        json::LazyDocument::Builder builder(document);
+        cbor::Parse(*section, builder);
+    } else {
+        document.Load(*section);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        std::cerr << "Usage: " << argv[0] << " [--input <file>] [--save-image <file>] [--load-image <file>] [--memory-stats] [--parallel-parse] [--compact] [--precision <n>] [--format json|cbor] [--serve]" << std::endl;
+        return 1;
+    }
+
+    if (options->serve) {
+        // Ответы не сбрасываются перед каждым чтением stdin, а буфер stdin виден
+        // потоку, и ServeStatRequests может отправлять ответы пачками
+        std::ios::sync_with_stdio(false);
+        std::cin.tie(nullptr);
+    }
+
     // Построение базы данных транспортного справочника
     transport::catalogue::TransportCatalogue catalogue;
+    // Образ объявлен раньше JSONReader и переживает его
+    std::optional<transport::catalogue::CatalogueImage> image;
     json_reader::JSONReader reader(catalogue);
-    const json::Array& base_requests = root.at(std::string(json_fields::BASE_REQUESTS)).AsArray();
-    const json::Array& stat_requests = root.at(std::string(json_fields::STAT_REQUESTS)).AsArray();
-    const json::Dict& render_settings_json = root.at(std::string(json_fields::RENDER_SETTINGS)).AsDict();
-    const json::Dict& routing_settings_json = root.at(std::string(json_fields::ROUTING_SETTINGS)).AsDict();
-    // Обрабатываем запросы base_requests (остановки и маршруты)
-    reader.ProcessBaseRequests(base_requests);
+    const bool load_image = !options->load_image.empty();
+    if (load_image) {
+        // Справочник берётся из готового образа, base_requests не разбираются.
+        // Stop и Bus отвечаются прямо из отображённых страниц; в обычный справочник
+        // образ копируется, только если понадобится маршрут, карта или дельта
+        image.emplace(options->load_image);
+        reader.AttachImage(*image);
+    }
+    // Чтение JSON из stdin или файла и потоковый разбор прямо из буфера:
+    // base_requests загружаются в справочник без построения дерева, а stat_requests
+    // разбираются позже по одному запросу
+    const InputBuffer input = !options->input.empty() ? InputBuffer(options->input)
+        : options->serve ? InputBuffer(std::cin)
+        : InputBuffer();
+    const bool cbor_format = options->format == Format::Cbor;
+    // Настройки читаются схемами прямо из раздела, дерево для них не строится
+    std::vector<std::string_view> skipped_sections{json_fields::STAT_REQUESTS,
+                                                   json_fields::RENDER_SETTINGS,
+                                                   json_fields::ROUTING_SETTINGS};
+    const bool parallel_parse = options->parallel_parse && !load_image && !cbor_format;
+    if (load_image || parallel_parse) {
+        skipped_sections.push_back(json_fields::BASE_REQUESTS);
+    }
+    const json::Dict root = cbor_format
+        ? reader.ProcessCborDocumentStream(input.GetView(), skipped_sections)
+        : reader.ProcessDocumentStream(input.GetView(), skipped_sections);
+    if (parallel_parse) {
+        // Раздел пропущен потоковым разбором и разбирается отдельно по частям
+        if (const auto base_requests = json::FindMember(input.GetView(), json_fields::BASE_REQUESTS)) {
+            reader.ProcessBaseRequestsParallel(*base_requests);
+        }
+    }
+    const auto stat_requests = cbor_format
+        ? cbor::FindMember(input.GetView(), json_fields::STAT_REQUESTS)
+        : json::FindMember(input.GetView(), json_fields::STAT_REQUESTS);
+    if (!stat_requests && !options->serve) {
+        throw std::out_of_range("Missing " + std::string(json_fields::STAT_REQUESTS));
+    }
+    json::LazyDocument render_settings_json;
+    json::LazyDocument routing_settings_json;
+    LoadSection(render_settings_json, input.GetView(), json_fields::RENDER_SETTINGS, cbor_format);
+    LoadSection(routing_settings_json, input.GetView(), json_fields::ROUTING_SETTINGS, cbor_format);
+    // После загрузки набор имён фиксируется; дельта перестраивает индексы только при его изменении
+    catalogue.Freeze();
+    if (const auto it = root.find(std::string(json_fields::DELTA_REQUESTS)); it != root.end()) {
+        reader.ApplyDeltaRequests(it->second.AsArray());
+    }
+    if (!options->save_image.empty()) {
+        reader.LoadAttachedImage();
+        transport::catalogue::SaveCatalogueImage(catalogue, options->save_image);
+    }
     // Парсинг render_settings из JSON
-    renderer::RenderSettings settings = reader.ParseRenderSettings(render_settings_json);
+    renderer::RenderSettings settings = reader.ParseRenderSettings(render_settings_json.GetRoot());
     renderer::MapRenderer renderer(settings);
     // Настройки маршрутизатора
-    transport::RoutingSettings routing_settings = reader.ParseRoutingSettings(routing_settings_json);
+    transport::RoutingSettings routing_settings = reader.ParseRoutingSettings(routing_settings_json.GetRoot());
     reader.SetRouter(routing_settings);
-    // Обработка запросов stat_requests и формирование ответа
-    json::Array responses = reader.ProcessStatRequests(stat_requests, renderer);
-    json::Document response_doc(responses);
-    json::Print(response_doc, std::cout);
-    std::cout << std::endl;
+    // Обработка запросов stat_requests: каждый ответ сразу пишется в вывод
+    if (options->serve) {
+        // Справочник, маршрутизатор и отрисованная карта остаются в памяти между
+        // запросами; stat_requests документа, если есть, не обрабатываются
+        reader.ServeStatRequests(std::cin, renderer, std::cout, options->print);
+    } else if (cbor_format) {
+        cbor::Writer writer(std::cout);
+        reader.ProcessCborStatRequestsStream(*stat_requests, renderer, writer);
+    } else {
+        reader.ProcessStatRequestsStream(*stat_requests, renderer, std::cout, options->print);
+        std::cout << std::endl;
+    }
+
+    if (options->memory_stats) {
+        PrintMemoryReport(reader.CollectMemoryUsage(renderer), std::cerr);
+    }
 
     return 0;
 }
\ No newline at end of file
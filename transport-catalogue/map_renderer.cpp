@@ -49,6 +49,29 @@ svg::Document MapRenderer::RenderMap(const TransportCatalogue& db) const {
     return doc;
 }
 
+void MapRenderer::CollectMemoryUsage(memory::MemoryReport& report) const {
+    memory::MemoryUsage palette = memory::ContainerUsage(settings_.color_palette);
+    for (const auto& color : settings_.color_palette) {
+        if (const auto* name = std::get_if<std::string>(&color)) {
+            palette += memory::ContainerUsage(*name);
+        }
+    }
+    report.push_back({"renderer.palette", palette});
+}
+
+bool MapRenderer::IsAffectedBy(const TransportCatalogue& db, const CatalogueChanges& changes) const {
+    if (changes.HasBusChanges()) {
+        return true;
+    }
+    for (const auto& name : changes.updatedStops) {
+        const Stop* stop = db.FindStop(name);
+        if (stop && !stop->buses.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 std::map<std::string_view, const transport::catalogue::Stop*> MapRenderer::CollectUsedStops(
     const std::vector<const transport::catalogue::Bus*>& buses) const {
     std::set<std::string_view> seen;
@@ -69,7 +92,7 @@ void MapRenderer::RenderRoutes( svg::Document& doc,
                                 const SphereProjector& projector) const {
     size_t color_index = 0;
     for (const Bus* bus : buses) {
-        const auto& stops = bus->stops;
+        const auto stops = bus->GetRouteStops();
         if (stops.empty()) continue;
 
         svg::Polyline polyline;
@@ -98,8 +121,8 @@ void MapRenderer::RenderBusLabels(svg::Document& doc,
         const svg::Color& color = settings_.color_palette[color_index % settings_.color_palette.size()];
         AddBusLabel(doc, bus->name, projector(bus->stops.front()->coords), color);
 
-        if (!bus->isRoundTrip && bus->originalStopCount > 1) {
-            const Stop* last_stop = bus->stops[bus->originalStopCount - 1];
+        if (!bus->isRoundTrip && bus->stops.size() > 1) {
+            const Stop* last_stop = bus->stops.back();
             if (last_stop != bus->stops.front()) {
                 svg::Point end_pos = projector(last_stop->coords);
                 AddBusLabel(doc, bus->name, end_pos, color);
@@ -182,4 +205,4 @@ void MapRenderer::AddBusLabel(svg::Document& doc, const std::string& name, svg::
     doc.Add(std::move(label));
 }
 
-}  // namespace renderer
+}  // namespace renderer
\ No newline at end of file
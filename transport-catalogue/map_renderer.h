@@ -9,6 +9,7 @@
 #include "svg.h"
 #include "transport_catalogue.h"
 #include "geo.h"
+#include "memory_usage.h"
 
 namespace renderer {
 
@@ -87,6 +88,10 @@ public:
     MapRenderer(const RenderSettings& settings);
 
     svg::Document RenderMap(const transport::catalogue::TransportCatalogue& db) const;
+    // Меняет ли дельта нарисованную карту: на ней только маршруты и их остановки
+    bool IsAffectedBy(const transport::catalogue::TransportCatalogue& db,
+                      const transport::catalogue::CatalogueChanges& changes) const;
+    void CollectMemoryUsage(memory::MemoryReport& report) const;
 
 private:
     RenderSettings settings_;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace memory {
+
+// Занятая память и число выделений блоков в куче
+struct MemoryUsage {
+    size_t bytes = 0;
+    size_t allocations = 0;
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        bytes += other.bytes;
+        allocations += other.allocations;
+        return *this;
+    }
+};
+
+struct ComponentUsage {
+    std::string name;
+    MemoryUsage usage;
+};
+
+// Отчёт по компонентам; имена вида "catalogue.stops", "router.graph.edges"
+using MemoryReport = std::vector<ComponentUsage>;
+
+inline MemoryUsage GetTotal(const MemoryReport& report) {
+    MemoryUsage total;
+    for (const auto& component : report) {
+        total += component.usage;
+    }
+    return total;
+}
+
+// Оценки ниже повторяют раскладку контейнеров libstdc++ и учитывают только
+// собственные блоки контейнера; память вложенных объектов считает вызывающий
+
+// Строки до 15 символов хранятся внутри объекта без выделения памяти
+inline constexpr size_t SSO_CAPACITY = 15;
+// Служебная часть узла красно-чёрного дерева: цвет и три указателя
+inline constexpr size_t TREE_NODE_HEADER = 32;
+// Размер блока, из которых состоит deque
+inline constexpr size_t DEQUE_BLOCK_BYTES = 512;
+
+inline MemoryUsage ContainerUsage(const std::string& value) {
+    if (value.capacity() <= SSO_CAPACITY) {
+        return {};
+    }
+    return {value.capacity() + 1, 1};
+}
+
+template <typename T>
+MemoryUsage ContainerUsage(const std::vector<T>& values) {
+    if (values.capacity() == 0) {
+        return {};
+    }
+    return {values.capacity() * sizeof(T), 1};
+}
+
+template <typename T>
+MemoryUsage ContainerUsage(const std::deque<T>& values) {
+    const size_t per_block = sizeof(T) < DEQUE_BLOCK_BYTES ? DEQUE_BLOCK_BYTES / sizeof(T) : 1;
+    const size_t blocks = values.size() / per_block + 1;
+    // Карта блоков занимает не меньше 8 указателей и держит запас по краям
+    const size_t map_size = std::max<size_t>(8, blocks + 2);
+    return {blocks * per_block * sizeof(T) + map_size * sizeof(void*), blocks + 1};
+}
+
+template <typename T, typename Compare>
+MemoryUsage ContainerUsage(const std::set<T, Compare>& values) {
+    return {values.size() * (TREE_NODE_HEADER + sizeof(T)), values.size()};
+}
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+MemoryUsage ContainerUsage(const std::unordered_map<Key, Value, Hash, Equal>& values) {
+    // Узел: указатель на следующий, пара ключ-значение и закешированный хеш
+    const size_t node_bytes = sizeof(void*) + sizeof(std::pair<const Key, Value>) + sizeof(size_t);
+    MemoryUsage usage{values.size() * node_bytes, values.size()};
+    // Единственная корзина пустой таблицы хранится внутри объекта
+    if (values.bucket_count() > 1) {
+        usage += MemoryUsage{values.bucket_count() * sizeof(void*), 1};
+    }
+    return usage;
+}
+
+}  // namespace memory
\ No newline at end of file
@@ -0,0 +1,301 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace transport::catalogue {
+
+namespace {
+
+// Маркер начала названия: триграммы с ним привязаны к началу строки
+constexpr char32_t BOUNDARY = U'\x01';
+// Замена байта, не образующего символ UTF-8
+constexpr char32_t REPLACEMENT = U'\xFFFD';
+
+constexpr size_t MIN_FUZZY_QUERY = 3;
+
+// Декодирует UTF-8 в кодовые точки; каждый неверный байт становится REPLACEMENT
+void DecodeUtf8(std::string_view text, std::u32string& out) {
+    out.clear();
+    for (size_t i = 0; i < text.size();) {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        const size_t length = lead < 0x80 ? 1 : (lead & 0xE0) == 0xC0 ? 2 : (lead & 0xF0) == 0xE0 ? 3
+            : (lead & 0xF8) == 0xF0 ? 4 : 0;
+        char32_t code = length == 1 ? lead : length == 2 ? lead & 0x1F : length == 3 ? lead & 0x0F : lead & 0x07;
+        bool valid = length != 0 && i + length <= text.size();
+        for (size_t k = 1; valid && k < length; ++k) {
+            const auto next = static_cast<unsigned char>(text[i + k]);
+            valid = (next & 0xC0) == 0x80;
+            code = code << 6 | (next & 0x3F);
+        }
+        // Слишком длинные записи и суррогаты не считаются символами
+        static constexpr char32_t MIN_CODE[] = {0, 0, 0x80, 0x800, 0x10000};
+        valid = valid && code >= MIN_CODE[length] && code <= 0x10FFFF && (code < 0xD800 || code > 0xDFFF);
+        out.push_back(valid ? code : REPLACEMENT);
+        i += valid ? length : 1;
+    }
+}
+
+void EncodeUtf8(char32_t code, std::string& out) {
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | code >> 6));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | code >> 12));
+        out.push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | code >> 18));
+        out.push_back(static_cast<char>(0x80 | (code >> 12 & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code >> 6 & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+// Простое приведение к нижнему регистру для латиницы, греческого и кириллицы
+char32_t FoldCase(char32_t code) {
+    // В блоках, где строчная буква следует сразу за заглавной, заглавная чётна
+    // или нечётна в зависимости от блока
+    auto pair_lower = [code](bool upper_is_even) {
+        return (code % 2 == 0) == upper_is_even ? code + 1 : code;
+    };
+    if (code < 0x80) {
+        return code >= U'A' && code <= U'Z' ? code + 0x20 : code;
+    }
+    if (code >= 0xC0 && code <= 0xDE && code != 0xD7) {
+        return code + 0x20;
+    }
+    if ((code >= 0x100 && code <= 0x137 && code != 0x130) || (code >= 0x14A && code <= 0x177)) {
+        return pair_lower(true);
+    }
+    if ((code >= 0x139 && code <= 0x148) || (code >= 0x179 && code <= 0x17E)) {
+        return pair_lower(false);
+    }
+    if (code == 0x178) {
+        return 0xFF;
+    }
+    if (code >= 0x391 && code <= 0x3AB && code != 0x3A2) {
+        return code + 0x20;
+    }
+    if (code >= 0x400 && code <= 0x40F) {
+        return code + 0x50;
+    }
+    if (code >= 0x410 && code <= 0x42F) {
+        return code + 0x20;
+    }
+    if ((code >= 0x460 && code <= 0x481) || (code >= 0x48A && code <= 0x4BF) || (code >= 0x4D0 && code <= 0x52F)) {
+        return pair_lower(true);
+    }
+    if (code == 0x4C0) {
+        return 0x4CF;
+    }
+    if (code >= 0x4C1 && code <= 0x4CE) {
+        return pair_lower(false);
+    }
+    return code;
+}
+
+}  // namespace
+
+NameIndex::NameIndex(const std::vector<std::pair<std::string_view, NameKind>>& names) {
+    entries_.reserve(names.size());
+    for (const auto& [name, kind] : names) {
+        entries_.push_back({Normalize(name), name, kind});
+    }
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.name < rhs.name;
+    });
+
+    struct TrigramPosting {
+        uint64_t trigram;
+        Posting posting;
+    };
+    std::vector<TrigramPosting> pairs;
+    std::u32string codes;
+    for (uint32_t id = 0; id < entries_.size(); ++id) {
+        DecodeUtf8(entries_[id].key, codes);
+        const auto trigrams = GetTrigrams(codes);
+        for (size_t position = 0; position < std::min(trigrams.size(), MAX_TRIGRAM_POSITION); ++position) {
+            pairs.push_back({trigrams[position], {static_cast<uint32_t>(position), id}});
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const TrigramPosting& lhs, const TrigramPosting& rhs) {
+        if (lhs.trigram != rhs.trigram) {
+            return lhs.trigram < rhs.trigram;
+        }
+        return lhs.posting.position != rhs.posting.position
+            ? lhs.posting.position < rhs.posting.position
+            : lhs.posting.id < rhs.posting.id;
+    });
+
+    postings_.reserve(pairs.size());
+    for (const auto& [trigram, posting] : pairs) {
+        auto [it, inserted] = trigrams_.try_emplace(trigram, Postings{static_cast<uint32_t>(postings_.size()), 0});
+        postings_.push_back(posting);
+        it->second.end = static_cast<uint32_t>(postings_.size());
+    }
+}
+
+std::string NameIndex::Normalize(std::string_view name) {
+    std::u32string codes;
+    DecodeUtf8(name, codes);
+    std::string key;
+    key.reserve(name.size());
+    for (const char32_t code : codes) {
+        EncodeUtf8(FoldCase(code), key);
+    }
+    return key;
+}
+
+std::vector<uint64_t> NameIndex::GetTrigrams(std::u32string_view key) {
+    std::u32string padded;
+    padded.reserve(key.size() + 1);
+    padded.push_back(BOUNDARY);
+    padded.append(key);
+
+    // Кодовая точка занимает 21 бит, три точки помещаются в 64 бита
+    std::vector<uint64_t> result;
+    for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+        result.push_back(static_cast<uint64_t>(padded[i]) << 42
+                       | static_cast<uint64_t>(padded[i + 1]) << 21
+                       | static_cast<uint64_t>(padded[i + 2]));
+    }
+    return result;
+}
+
+int NameIndex::GetTypoLimit(std::u32string_view query) {
+    if (query.size() >= 8) {
+        return 2;
+    }
+    return query.size() >= MIN_FUZZY_QUERY ? 1 : 0;
+}
+
+int NameIndex::GetPrefixDistance(std::u32string_view query, std::u32string_view key, int limit) {
+    // Наименьшее расстояние Левенштейна между запросом и каким-либо префиксом key.
+    // Строка row[j] хранит расстояние между прочитанной частью запроса и key[0, j)
+    const size_t width = std::min(key.size(), query.size() + limit) + 1;
+    std::vector<int> row(width);
+    std::iota(row.begin(), row.end(), 0);
+
+    for (size_t i = 1; i <= query.size(); ++i) {
+        int diagonal = row[0];
+        row[0] = static_cast<int>(i);
+        int row_min = row[0];
+        for (size_t j = 1; j < width; ++j) {
+            const int substitution = diagonal + (query[i - 1] == key[j - 1] ? 0 : 1);
+            diagonal = row[j];
+            row[j] = std::min({substitution, row[j] + 1, row[j - 1] + 1});
+            row_min = std::min(row_min, row[j]);
+        }
+        if (row_min > limit) {
+            return limit + 1;
+        }
+    }
+    return *std::min_element(row.begin(), row.end());
+}
+
+std::vector<NameSuggestion> NameIndex::Suggest(std::string_view query, size_t count,
+                                               std::optional<NameKind> kind) const {
+    std::vector<NameSuggestion> result;
+    if (count == 0) {
+        return result;
+    }
+    const std::string key = Normalize(query);
+    auto accepts = [&kind](const Entry& entry) {
+        return !kind || entry.kind == *kind;
+    };
+
+    // Точные совпадения префикса — непрерывный отрезок отсортированного массива
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), key, [](const Entry& entry, const std::string& value) {
+        return entry.key < value;
+    });
+    for (; it != entries_.end() && it->key.compare(0, key.size(), key) == 0 && result.size() < count; ++it) {
+        if (accepts(*it)) {
+            result.push_back({it->name, it->kind, 0});
+        }
+    }
+
+    // Опечатки и триграммы считаются в символах, а не в байтах UTF-8
+    std::u32string query_codes;
+    DecodeUtf8(key, query_codes);
+    const int limit = GetTypoLimit(query_codes);
+    if (result.size() >= count || limit == 0) {
+        return result;
+    }
+
+    // Кандидаты с опечатками: названия, у которых достаточно триграмм запроса
+    // встречается примерно на тех же позициях. Одна опечатка портит не больше
+    // трёх триграмм и сдвигает остальные не больше чем на одну позицию
+    auto query_trigrams = GetTrigrams(query_codes);
+    query_trigrams.resize(std::min(query_trigrams.size(), MAX_TRIGRAM_POSITION));
+
+    // Счётчики совпадений на каждое название переиспользуются между запросами потока
+    thread_local std::vector<uint8_t> hits;
+    thread_local std::vector<uint32_t> touched;
+    hits.resize(std::max(hits.size(), entries_.size()));
+    touched.clear();
+
+    for (size_t position = 0; position < query_trigrams.size(); ++position) {
+        auto found = trigrams_.find(query_trigrams[position]);
+        if (found == trigrams_.end()) {
+            continue;
+        }
+        const auto begin = postings_.begin() + found->second.begin;
+        const auto end = postings_.begin() + found->second.end;
+        const uint32_t min_position = position > static_cast<size_t>(limit) ? static_cast<uint32_t>(position - limit) : 0;
+        const uint32_t max_position = static_cast<uint32_t>(position + limit);
+        auto it = std::lower_bound(begin, end, min_position, [](const Posting& posting, uint32_t value) {
+            return posting.position < value;
+        });
+        for (; it != end && it->position <= max_position; ++it) {
+            if (hits[it->id]++ == 0) {
+                touched.push_back(it->id);
+            }
+        }
+    }
+    const int required = std::max(1, static_cast<int>(query_trigrams.size()) - 3 * limit);
+
+    struct Candidate {
+        int typos;
+        uint32_t id;
+    };
+    std::vector<Candidate> candidates;
+    std::u32string entry_codes;
+    for (uint32_t id : touched) {
+        const int shared = hits[id];
+        hits[id] = 0;
+        const Entry& entry = entries_[id];
+        if (shared < required || !accepts(entry) || entry.key.compare(0, key.size(), key) == 0) {
+            continue;
+        }
+        DecodeUtf8(entry.key, entry_codes);
+        if (const int typos = GetPrefixDistance(query_codes, entry_codes, limit); typos <= limit) {
+            candidates.push_back({typos, id});
+        }
+    }
+
+    const size_t needed = std::min(candidates.size(), count - result.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + needed, candidates.end(),
+        [](const Candidate& lhs, const Candidate& rhs) {
+            return lhs.typos != rhs.typos ? lhs.typos < rhs.typos : lhs.id < rhs.id;
+        });
+    for (size_t i = 0; i < needed; ++i) {
+        const Entry& entry = entries_[candidates[i].id];
+        result.push_back({entry.name, entry.kind, candidates[i].typos});
+    }
+    return result;
+}
+
+memory::MemoryUsage NameIndex::GetMemoryUsage() const {
+    memory::MemoryUsage usage = memory::ContainerUsage(entries_);
+    for (const auto& entry : entries_) {
+        usage += memory::ContainerUsage(entry.key);
+    }
+    usage += memory::ContainerUsage(trigrams_);
+    usage += memory::ContainerUsage(postings_);
+    return usage;
+}
+
+}  // namespace transport::catalogue
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_usage.h"
+
+namespace transport::catalogue {
+
+enum class NameKind { Stop, Bus };
+
+struct NameSuggestion {
+    std::string_view name;
+    NameKind kind = NameKind::Stop;
+    int typos = 0;
+};
+
+// Индекс для автодополнения названий остановок и маршрутов.
+// Нормализованные названия (UTF-8, латиница, греческий и кириллица в нижнем
+// регистре) хранятся отсортированными, поэтому все названия с заданным префиксом
+// образуют непрерывный отрезок, как поддерево в префиксном дереве. Для устойчивости
+// к опечаткам есть индекс триграмм символов: кандидаты с общими триграммами
+// проверяются расстоянием Левенштейна в символах до префикса названия
+class NameIndex {
+public:
+    NameIndex() = default;
+    // Названия должны жить дольше индекса
+    explicit NameIndex(const std::vector<std::pair<std::string_view, NameKind>>& names);
+
+    // До count подсказок: сначала точные совпадения префикса в алфавитном порядке,
+    // затем совпадения с опечатками по возрастанию их числа
+    std::vector<NameSuggestion> Suggest(std::string_view query, size_t count,
+                                        std::optional<NameKind> kind = std::nullopt) const;
+
+    memory::MemoryUsage GetMemoryUsage() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::string_view name;
+        NameKind kind;
+    };
+
+    struct Postings {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    // Вхождение триграммы: позиция в названии и номер названия
+    struct Posting {
+        uint32_t position;
+        uint32_t id;
+    };
+
+    // Учитываются только триграммы из начала названия: подсказки ищутся по префиксу
+    static constexpr size_t MAX_TRIGRAM_POSITION = 32;
+
+    static std::string Normalize(std::string_view name);
+    // Триграммы кодовых точек с маркером начала названия
+    static std::vector<uint64_t> GetTrigrams(std::u32string_view key);
+    static int GetPrefixDistance(std::u32string_view query, std::u32string_view key, int limit);
+    static int GetTypoLimit(std::u32string_view query);
+
+    std::vector<Entry> entries_;
+    std::unordered_map<uint64_t, Postings> trigrams_;
+    std::vector<Posting> postings_;
+};
+
+}  // namespace transport::catalogue
\ No newline at end of file
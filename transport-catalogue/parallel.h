@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Минимальный объём работы, ради которого имеет смысл запускать отдельный поток
+inline constexpr size_t DEFAULT_MIN_CHUNK = 1024;
+
+// Количество потоков для обработки work_items элементов
+inline size_t GetThreadCount(size_t work_items, size_t min_chunk = DEFAULT_MIN_CHUNK) {
+    const size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t by_work = std::max<size_t>(1, work_items / std::max<size_t>(1, min_chunk));
+    return std::min(hardware, by_work);
+}
+
+// Разбивает диапазон [0, count) на непрерывные части и вызывает func(begin, end)
+// для каждой из них в отдельном потоке. Исключения пробрасываются вызывающему
+template <typename Func>
+void ForEachChunk(size_t count, Func func, size_t min_chunk = DEFAULT_MIN_CHUNK) {
+    const size_t threads = GetThreadCount(count, min_chunk);
+    if (threads <= 1) {
+        func(size_t{0}, count);
+        return;
+    }
+
+    const size_t chunk = (count + threads - 1) / threads;
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(threads - 1);
+    for (size_t begin = chunk; begin < count; begin += chunk) {
+        const size_t end = std::min(count, begin + chunk);
+        tasks.push_back(std::async(std::launch::async, [&func, begin, end] {
+            func(begin, end);
+        }));
+    }
+    func(size_t{0}, std::min(count, chunk));
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+// Вычисляет частичный результат func(begin, end) для каждой части диапазона [0, count)
+// в отдельном потоке и сводит их в порядке частей через reduce(accumulated, std::move(partial))
+template <typename Result, typename Func, typename Reduce>
+Result ChunkedReduce(size_t count, Result init, Func func, Reduce reduce, size_t min_chunk = DEFAULT_MIN_CHUNK) {
+    const size_t threads = GetThreadCount(count, min_chunk);
+    if (threads <= 1) {
+        reduce(init, func(size_t{0}, count));
+        return init;
+    }
+
+    const size_t chunk = (count + threads - 1) / threads;
+    std::vector<std::future<Result>> tasks;
+    tasks.reserve(threads - 1);
+    for (size_t begin = chunk; begin < count; begin += chunk) {
+        const size_t end = std::min(count, begin + chunk);
+        tasks.push_back(std::async(std::launch::async, [&func, begin, end] {
+            return func(begin, end);
+        }));
+    }
+    reduce(init, func(size_t{0}, std::min(count, chunk)));
+    for (auto& task : tasks) {
+        reduce(init, task.get());
+    }
+    return init;
+}
+
+// Выполняет независимые задачи одновременно и дожидается их завершения
+template <typename First, typename... Rest>
+void Invoke(First&& first, Rest&&... rest) {
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(sizeof...(rest));
+    (tasks.push_back(std::async(std::launch::async, std::forward<Rest>(rest))), ...);
+    first();
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+}  // namespace parallel
\ No newline at end of file
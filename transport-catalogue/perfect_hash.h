@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "memory_usage.h"
+
+namespace perfect_hash {
+
+// Перемешивание битов из splitmix64
+constexpr uint64_t Mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// Минимальная совершенная хеш-функция над неизменяемым набором строковых ключей
+// (схема «хеширование и смещение», как в CHD). Ключи раскладываются по корзинам,
+// для каждой корзины подбирается зерно, отправляющее все её ключи в свободные ячейки.
+// Корзины из одного ключа занимают оставшиеся ячейки напрямую, поэтому таблица
+// содержит ровно столько ячеек, сколько ключей. Ячейка занимает 16 байт: отпечаток
+// хеша, смещение ключа и значение, по четыре ячейки на строку кеша. Копии ключей
+// лежат подряд в собственном буфере индекса и читаются, только если совпал
+// отпечаток, поэтому промах не касается строк, а попадание не идёт по указателям
+template <typename Value>
+class PerfectHashIndex {
+public:
+    using Item = std::pair<std::string_view, Value*>;
+
+    PerfectHashIndex() = default;
+
+    // Ключи должны быть уникальными; индекс хранит их копии
+    explicit PerfectHashIndex(const std::vector<Item>& items);
+
+    Value* Find(std::string_view key) const;
+
+    size_t GetSize() const {
+        return slots_.size();
+    }
+
+    bool IsEmpty() const {
+        return slots_.empty();
+    }
+
+    memory::MemoryUsage GetMemoryUsage() const {
+        memory::MemoryUsage usage = memory::ContainerUsage(seeds_);
+        usage += memory::ContainerUsage(slots_);
+        usage += memory::ContainerUsage(keys_);
+        return usage;
+    }
+
+private:
+    struct Slot {
+        uint32_t fingerprint = 0;
+        // Смещение в keys_ длины ключа, за которой идут его байты
+        uint32_t key = 0;
+        Value* value = nullptr;
+    };
+    static_assert(sizeof(Slot) == 16, "Four slots per cache line");
+
+    static constexpr uint32_t DIRECT_FLAG = 0x80000000u;
+    static constexpr double KEYS_PER_BUCKET = 4.0;
+    static constexpr uint32_t MAX_SEED = 1u << 20;
+    static constexpr uint32_t MAX_SALT = 16;
+
+    uint64_t Hash(std::string_view key) const {
+        return Mix(std::hash<std::string_view>{}(key) ^ salt_);
+    }
+
+    static uint32_t GetFingerprint(uint64_t hash) {
+        return static_cast<uint32_t>(hash);
+    }
+
+    std::string_view GetKey(const Slot& slot) const {
+        uint32_t length = 0;
+        std::memcpy(&length, keys_.data() + slot.key, sizeof(length));
+        return {keys_.data() + slot.key + sizeof(length), length};
+    }
+
+    size_t GetBucket(uint64_t hash) const {
+        return static_cast<size_t>((hash >> 32) % seeds_.size());
+    }
+
+    size_t GetSlot(uint64_t hash, uint32_t seed) const {
+        if (seed & DIRECT_FLAG) {
+            return seed & ~DIRECT_FLAG;
+        }
+        return static_cast<size_t>(Mix(hash ^ (static_cast<uint64_t>(seed) << 32)) % slots_.size());
+    }
+
+    bool TryBuild(const std::vector<Item>& items);
+    // Копирует ключи в keys_ в порядке ячеек
+    void StoreKeys(const std::vector<Item>& items, const std::vector<size_t>& slot_items);
+
+    std::vector<uint32_t> seeds_;
+    std::vector<Slot> slots_;
+    std::vector<char> keys_;
+    uint64_t salt_ = 0;
+};
+
+template <typename Value>
+PerfectHashIndex<Value>::PerfectHashIndex(const std::vector<Item>& items) {
+    if (items.empty()) {
+        return;
+    }
+    for (uint64_t salt = 0; salt < MAX_SALT; ++salt) {
+        salt_ = Mix(salt);
+        if (TryBuild(items)) {
+            return;
+        }
+    }
+    throw std::runtime_error("Failed to build perfect hash index");
+}
+
+template <typename Value>
+bool PerfectHashIndex<Value>::TryBuild(const std::vector<Item>& items) {
+    const size_t bucket_count = std::max<size_t>(1, static_cast<size_t>(items.size() / KEYS_PER_BUCKET));
+    seeds_.assign(bucket_count, 0);
+    slots_.assign(items.size(), Slot{});
+
+    std::vector<uint64_t> hashes(items.size());
+    std::vector<std::vector<size_t>> buckets(bucket_count);
+    for (size_t i = 0; i < items.size(); ++i) {
+        hashes[i] = Hash(items[i].first);
+        buckets[GetBucket(hashes[i])].push_back(i);
+    }
+
+    // Крупные корзины размещаются первыми, пока в таблице много свободных ячеек
+    std::vector<size_t> order(bucket_count);
+    for (size_t i = 0; i < bucket_count; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    std::vector<bool> taken(slots_.size(), false);
+    // Номер элемента items в каждой ячейке
+    std::vector<size_t> slot_items(slots_.size());
+    std::vector<size_t> positions;
+    size_t next_free = 0;
+
+    for (size_t bucket : order) {
+        const auto& keys = buckets[bucket];
+        if (keys.empty()) {
+            break;
+        }
+
+        if (keys.size() == 1) {
+            while (taken[next_free]) {
+                ++next_free;
+            }
+            seeds_[bucket] = static_cast<uint32_t>(next_free) | DIRECT_FLAG;
+            taken[next_free] = true;
+            slots_[next_free] = {GetFingerprint(hashes[keys.front()]), 0, items[keys.front()].second};
+            slot_items[next_free] = keys.front();
+            continue;
+        }
+
+        bool placed = false;
+        for (uint32_t seed = 0; seed < MAX_SEED && !placed; ++seed) {
+            positions.clear();
+            placed = true;
+            for (size_t key : keys) {
+                const size_t slot = GetSlot(hashes[key], seed);
+                if (taken[slot] || std::find(positions.begin(), positions.end(), slot) != positions.end()) {
+                    placed = false;
+                    break;
+                }
+                positions.push_back(slot);
+            }
+            if (placed) {
+                seeds_[bucket] = seed;
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    taken[positions[i]] = true;
+                    slots_[positions[i]] = {GetFingerprint(hashes[keys[i]]), 0, items[keys[i]].second};
+                    slot_items[positions[i]] = keys[i];
+                }
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    StoreKeys(items, slot_items);
+    return true;
+}
+
+template <typename Value>
+void PerfectHashIndex<Value>::StoreKeys(const std::vector<Item>& items, const std::vector<size_t>& slot_items) {
+    size_t total = 0;
+    for (const auto& [key, _] : items) {
+        total += sizeof(uint32_t) + key.size();
+    }
+    if (total > UINT32_MAX) {
+        throw std::length_error("Perfect hash keys do not fit 32-bit offsets");
+    }
+    keys_.clear();
+    keys_.reserve(total);
+    for (size_t slot = 0; slot < slots_.size(); ++slot) {
+        const std::string_view key = items[slot_items[slot]].first;
+        const uint32_t length = static_cast<uint32_t>(key.size());
+        slots_[slot].key = static_cast<uint32_t>(keys_.size());
+        keys_.resize(keys_.size() + sizeof(length));
+        std::memcpy(keys_.data() + slots_[slot].key, &length, sizeof(length));
+        keys_.insert(keys_.end(), key.begin(), key.end());
+    }
+}
+
+template <typename Value>
+Value* PerfectHashIndex<Value>::Find(std::string_view key) const {
+    if (slots_.empty()) {
+        return nullptr;
+    }
+    const uint64_t hash = Hash(key);
+    const Slot& slot = slots_[GetSlot(hash, seeds_[GetBucket(hash)])];
+    if (slot.fingerprint != GetFingerprint(hash) || GetKey(slot) != key) {
+        return nullptr;
+    }
+    return slot.value;
+}
+
+// Совершенная хеш-функция над набором ключей, известным при компиляции, например
+// именами полей и типов запросов. Зерно подбирается при вычислении конструктора так,
+// чтобы все ключи попали в разные ячейки таблицы; если такого нет, таблица не
+// компилируется. Хеш берёт длину ключа и три его символа, поэтому поиск стоит
+// одного перемешивания и одного сравнения строк, подтверждающего ячейку
+template <typename Value, size_t N>
+class StaticPerfectHash {
+public:
+    using Item = std::pair<std::string_view, Value>;
+
+    constexpr explicit StaticPerfectHash(const Item (&items)[N]) {
+        for (uint64_t seed = 0; seed < MAX_SEED; ++seed) {
+            if (TryBuild(items, seed)) {
+                seed_ = seed;
+                return;
+            }
+        }
+        throw std::logic_error("Failed to build static perfect hash");
+    }
+
+    constexpr std::optional<Value> Find(std::string_view key) const {
+        const Slot& slot = slots_[GetSlot(key, seed_)];
+        if (!slot.used || slot.key != key) {
+            return std::nullopt;
+        }
+        return slot.value;
+    }
+
+private:
+    struct Slot {
+        std::string_view key;
+        Value value{};
+        bool used = false;
+    };
+
+    // Не меньше двух ячеек на ключ, размер — степень двойки
+    static constexpr size_t GetTableSize() {
+        size_t size = 1;
+        while (size < 2 * N) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    static constexpr size_t SIZE = GetTableSize();
+    static constexpr uint64_t MAX_SEED = 1u << 16;
+
+    static constexpr size_t GetSlot(std::string_view key, uint64_t seed) {
+        uint64_t sample = key.size() << 24;
+        if (!key.empty()) {
+            sample |= uint64_t{static_cast<unsigned char>(key.front())} << 16;
+            sample |= uint64_t{static_cast<unsigned char>(key[key.size() / 2])} << 8;
+            sample |= uint64_t{static_cast<unsigned char>(key.back())};
+        }
+        return static_cast<size_t>(Mix(sample ^ (seed << 40)) & (SIZE - 1));
+    }
+
+    constexpr bool TryBuild(const Item (&items)[N], uint64_t seed) {
+        for (Slot& slot : slots_) {
+            slot = Slot{};
+        }
+        for (const auto& [key, value] : items) {
+            Slot& slot = slots_[GetSlot(key, seed)];
+            if (slot.used) {
+                return false;
+            }
+            slot = Slot{key, value, true};
+        }
+        return true;
+    }
+
+    Slot slots_[SIZE] = {};
+    uint64_t seed_ = 0;
+};
+
+template <typename Value, size_t N>
+constexpr StaticPerfectHash<Value, N> MakeStaticPerfectHash(const std::pair<std::string_view, Value> (&items)[N]) {
+    return StaticPerfectHash<Value, N>(items);
+}
+
+}  // namespace perfect_hash
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graph.h"
+#include "memory_usage.h"
 
 #include <algorithm>
 #include <cassert>
@@ -28,6 +29,18 @@ public:
     };
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Учитывает вершины и рёбра, добавленные в граф после построения, начиная с
+    // ребра first_edge. Рёбра и вершины графа не должны удаляться или меняться
+    void AddEdges(EdgeId first_edge);
+
+    // Таблица кратчайших путей занимает O(V^2) памяти
+    memory::MemoryUsage GetMemoryUsage() const {
+        memory::MemoryUsage usage = memory::ContainerUsage(routes_internal_data_);
+        for (const auto& row : routes_internal_data_) {
+            usage += memory::ContainerUsage(row);
+        }
+        return usage;
+    }
 
 private:
     struct RouteInternalData {
@@ -94,6 +107,42 @@ Router<Weight>::Router(const Graph& graph)
     }
 }
 
+template <typename Weight>
+void Router<Weight>::AddEdges(EdgeId first_edge) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const size_t old_vertex_count = routes_internal_data_.size();
+    for (auto& row : routes_internal_data_) {
+        row.resize(vertex_count);
+    }
+    routes_internal_data_.resize(vertex_count, std::vector<std::optional<RouteInternalData>>(vertex_count));
+    for (VertexId vertex = old_vertex_count; vertex < vertex_count; ++vertex) {
+        routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+    }
+
+    std::vector<VertexId> endpoints;
+    for (EdgeId edge_id = first_edge; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        auto& route_internal_data = routes_internal_data_[edge.from][edge.to];
+        if (!route_internal_data || route_internal_data->weight > edge.weight) {
+            route_internal_data = RouteInternalData{edge.weight, edge_id};
+        }
+        endpoints.push_back(edge.from);
+        endpoints.push_back(edge.to);
+    }
+    std::sort(endpoints.begin(), endpoints.end());
+    endpoints.erase(std::unique(endpoints.begin(), endpoints.end()), endpoints.end());
+
+    // Новый кратчайший путь состоит из старых кратчайших путей, соединённых новыми
+    // рёбрами, поэтому промежуточными вершинами достаточно перебрать только концы
+    // новых рёбер: O(K·V^2) вместо O(V^3) на полное построение
+    for (const VertexId vertex_through : endpoints) {
+        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    }
+}
+
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
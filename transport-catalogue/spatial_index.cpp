@@ -0,0 +1,208 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace transport {
+
+using namespace catalogue;
+
+namespace {
+
+double Square(double value) {
+    return value * value;
+}
+
+double SquaredDistance(const std::array<double, 3>& lhs, const std::array<double, 3>& rhs) {
+    return Square(lhs[0] - rhs[0]) + Square(lhs[1] - rhs[1]) + Square(lhs[2] - rhs[2]);
+}
+
+// Длина хорды единичной сферы, соответствующая дуге длиной distance метров
+double DistanceToChord(double distance) {
+    if (distance >= M_PI * geo::EARTH_RADIUS) {
+        return 2.0;
+    }
+    return 2.0 * std::sin(distance / (2.0 * geo::EARTH_RADIUS));
+}
+
+double ChordToDistance(double chord) {
+    return 2.0 * std::asin(std::min(1.0, chord / 2.0)) * geo::EARTH_RADIUS;
+}
+
+}  // namespace
+
+StopSpatialIndex::StopSpatialIndex(const TransportCatalogue& db) {
+    entries_.reserve(db.GetStops().size());
+    for (const Stop& stop : db.GetStops()) {
+        entries_.push_back({&stop, ToPoint(stop.coords)});
+    }
+
+    if (!entries_.empty()) {
+        nodes_.reserve(2 * (entries_.size() / LEAF_SIZE + 1));
+        Build(0, entries_.size());
+    }
+}
+
+StopSpatialIndex::Point StopSpatialIndex::ToPoint(geo::Coordinates coords) {
+    const double dr = M_PI / 180.0;
+    const double lat = coords.lat * dr;
+    const double lng = coords.lng * dr;
+    return {std::cos(lat) * std::cos(lng), std::cos(lat) * std::sin(lng), std::sin(lat)};
+}
+
+size_t StopSpatialIndex::Build(size_t begin, size_t end) {
+    const size_t id = nodes_.size();
+    nodes_.emplace_back();
+
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.min_point = node.max_point = entries_[begin].point;
+    node.min_coords = node.max_coords = entries_[begin].stop->coords;
+    for (size_t i = begin; i < end; ++i) {
+        const Entry& entry = entries_[i];
+        for (size_t axis = 0; axis < 3; ++axis) {
+            node.min_point[axis] = std::min(node.min_point[axis], entry.point[axis]);
+            node.max_point[axis] = std::max(node.max_point[axis], entry.point[axis]);
+        }
+        node.min_coords.lat = std::min(node.min_coords.lat, entry.stop->coords.lat);
+        node.min_coords.lng = std::min(node.min_coords.lng, entry.stop->coords.lng);
+        node.max_coords.lat = std::max(node.max_coords.lat, entry.stop->coords.lat);
+        node.max_coords.lng = std::max(node.max_coords.lng, entry.stop->coords.lng);
+    }
+
+    if (end - begin > LEAF_SIZE) {
+        size_t axis = 0;
+        for (size_t i = 1; i < 3; ++i) {
+            if (node.max_point[i] - node.min_point[i] > node.max_point[axis] - node.min_point[axis]) {
+                axis = i;
+            }
+        }
+
+        const size_t middle = begin + (end - begin) / 2;
+        std::nth_element(entries_.begin() + begin, entries_.begin() + middle, entries_.begin() + end,
+            [axis](const Entry& lhs, const Entry& rhs) {
+                return lhs.point[axis] < rhs.point[axis];
+            });
+        node.left = Build(begin, middle);
+        node.right = Build(middle, end);
+    }
+
+    nodes_[id] = node;
+    return id;
+}
+
+double StopSpatialIndex::SquaredDistanceToBox(const Point& point, const Node& node) {
+    double result = 0.0;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        if (point[axis] < node.min_point[axis]) {
+            result += Square(node.min_point[axis] - point[axis]);
+        } else if (point[axis] > node.max_point[axis]) {
+            result += Square(point[axis] - node.max_point[axis]);
+        }
+    }
+    return result;
+}
+
+std::vector<NearbyStop> StopSpatialIndex::FindNearest(geo::Coordinates center, size_t count, double radius) const {
+    std::vector<NearbyStop> result;
+    if (nodes_.empty() || count == 0 || radius < 0) {
+        return result;
+    }
+
+    const Point target = ToPoint(center);
+    double limit = Square(DistanceToChord(radius));
+
+    // Лучшие найденные кандидаты: на вершине кучи — самый дальний из них
+    using Candidate = std::pair<double, const Stop*>;
+    std::priority_queue<Candidate> best;
+
+    // Узлы обходятся в порядке возрастания расстояния до их габарита
+    using Pending = std::pair<double, size_t>;
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<>> pending;
+    pending.push({SquaredDistanceToBox(target, nodes_.front()), 0});
+
+    while (!pending.empty()) {
+        const auto [box_distance, id] = pending.top();
+        pending.pop();
+        if (box_distance > limit) {
+            break;
+        }
+
+        const Node& node = nodes_[id];
+        if (!node.IsLeaf()) {
+            for (size_t child : {node.left, node.right}) {
+                const double child_distance = SquaredDistanceToBox(target, nodes_[child]);
+                if (child_distance <= limit) {
+                    pending.push({child_distance, child});
+                }
+            }
+            continue;
+        }
+
+        for (size_t i = node.begin; i < node.end; ++i) {
+            const double distance = SquaredDistance(target, entries_[i].point);
+            if (distance > limit) {
+                continue;
+            }
+            best.push({distance, entries_[i].stop});
+            if (best.size() > count) {
+                best.pop();
+            }
+            if (best.size() == count) {
+                limit = std::min(limit, best.top().first);
+            }
+        }
+    }
+
+    result.resize(best.size());
+    for (auto it = result.rbegin(); it != result.rend(); ++it) {
+        *it = {best.top().second, ChordToDistance(std::sqrt(best.top().first))};
+        best.pop();
+    }
+    return result;
+}
+
+std::vector<const Stop*> StopSpatialIndex::FindInBox(geo::Coordinates min, geo::Coordinates max) const {
+    std::vector<const Stop*> result;
+    if (nodes_.empty()) {
+        return result;
+    }
+
+    auto inside = [&min, &max](geo::Coordinates coords) {
+        return coords.lat >= min.lat && coords.lat <= max.lat
+            && coords.lng >= min.lng && coords.lng <= max.lng;
+    };
+
+    std::vector<size_t> pending = {0};
+    while (!pending.empty()) {
+        const Node& node = nodes_[pending.back()];
+        pending.pop_back();
+
+        if (node.max_coords.lat < min.lat || node.min_coords.lat > max.lat
+            || node.max_coords.lng < min.lng || node.min_coords.lng > max.lng) {
+            continue;
+        }
+
+        // Поддерево целиком внутри области — забираем без проверки каждой точки
+        if (inside(node.min_coords) && inside(node.max_coords)) {
+            for (size_t i = node.begin; i < node.end; ++i) {
+                result.push_back(entries_[i].stop);
+            }
+        } else if (node.IsLeaf()) {
+            for (size_t i = node.begin; i < node.end; ++i) {
+                if (inside(entries_[i].stop->coords)) {
+                    result.push_back(entries_[i].stop);
+                }
+            }
+        } else {
+            pending.push_back(node.left);
+            pending.push_back(node.right);
+        }
+    }
+    return result;
+}
+
+}  // namespace transport
\ No newline at end of file
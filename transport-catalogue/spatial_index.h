@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "geo.h"
+#include "memory_usage.h"
+#include "transport_catalogue.h"
+
+namespace transport {
+
+struct NearbyStop {
+    const catalogue::Stop* stop = nullptr;
+    double distance = 0.0;
+};
+
+// Пространственный индекс остановок, строится один раз по Stop::coords.
+// Точки переводятся в декартовы координаты на единичной сфере, поэтому порядок
+// по длине хорды совпадает с порядком по расстоянию на поверхности Земли.
+// Каждый узел k-d дерева хранит и объёмный габарит, и габарит по широте/долготе,
+// что позволяет отсекать поддеревья и в поиске ближайших, и в запросах по области
+class StopSpatialIndex {
+public:
+    explicit StopSpatialIndex(const catalogue::TransportCatalogue& db);
+
+    // До count ближайших к center остановок не дальше radius метров, по возрастанию расстояния
+    std::vector<NearbyStop> FindNearest(geo::Coordinates center, size_t count,
+                                        double radius = std::numeric_limits<double>::infinity()) const;
+
+    // Остановки, чьи координаты попадают в прямоугольник [min; max] по широте и долготе
+    std::vector<const catalogue::Stop*> FindInBox(geo::Coordinates min, geo::Coordinates max) const;
+
+    size_t GetStopCount() const {
+        return entries_.size();
+    }
+
+    memory::MemoryUsage GetMemoryUsage() const {
+        memory::MemoryUsage usage = memory::ContainerUsage(entries_);
+        usage += memory::ContainerUsage(nodes_);
+        return usage;
+    }
+
+private:
+    using Point = std::array<double, 3>;
+
+    struct Entry {
+        const catalogue::Stop* stop;
+        Point point;
+    };
+
+    struct Node {
+        size_t begin = 0;
+        size_t end = 0;
+        size_t left = 0;
+        size_t right = 0;
+        Point min_point;
+        Point max_point;
+        geo::Coordinates min_coords;
+        geo::Coordinates max_coords;
+
+        bool IsLeaf() const {
+            return left == 0;
+        }
+    };
+
+    static constexpr size_t LEAF_SIZE = 8;
+
+    size_t Build(size_t begin, size_t end);
+    static Point ToPoint(geo::Coordinates coords);
+    static double SquaredDistanceToBox(const Point& point, const Node& node);
+
+    std::vector<Entry> entries_;
+    std::vector<Node> nodes_;
+};
+
+}  // namespace transport
\ No newline at end of file
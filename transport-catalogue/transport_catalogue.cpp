@@ -1,74 +1,261 @@
 #include "transport_catalogue.h"
+#include "parallel.h"
 #include <algorithm>
 #include <unordered_set>
 
 namespace transport::catalogue {
 
+    TransportCatalogue::TransportCatalogue(const TransportCatalogue& other) {
+        for (const Stop& stop : other.GetStops()) {
+            AddStop(stop.name, stop.coords);
+        }
+
+        for (const auto& [stops, distance] : other.distances_) {
+            SetDistanceBetweenStops(FindStop(stops.first->name), FindStop(stops.second->name), distance);
+        }
+
+        for (const Bus& bus : other.GetBuses()) {
+            std::vector<std::string> stopNames;
+            stopNames.reserve(bus.stops.size());
+            for (const Stop* stop : bus.stops) {
+                stopNames.push_back(stop->name);
+            }
+            AddBus(bus.name, stopNames, bus.isRoundTrip);
+        }
+
+        // Копия продолжает нумерацию версий и сохраняет фиксацию имён: иначе после
+        // публикации версии шли бы назад, а поиск терял совершенные хеш-таблицы
+        version_ = other.version_;
+        if (other.IsFrozen()) {
+            Freeze();
+        }
+    }
+
     void TransportCatalogue::AddStop(const std::string_view& name, const geo::Coordinates& coords){
+        Unfreeze();
         stops_.push_back(Stop{std::string(name), coords, {}});
         Stop* stopPtr = &stops_.back();
         stopsByName_[stopPtr->name] = stopPtr;
     }
 
     void TransportCatalogue::AddBus(const std::string_view& name, const std::vector<std::string>& stopNames, const bool is_roundtrip){
+        Unfreeze();
         buses_.push_back(Bus{std::string(name), {}, is_roundtrip});
         Bus* busPtr = &buses_.back();
         busesByName_[busPtr->name] = busPtr;
+        SetBusStops(*busPtr, stopNames);
+    }
+
+    void TransportCatalogue::SetBusStops(Bus& bus, const std::vector<std::string>& stopNames) {
+        for (Stop* stop : bus.stops) {
+            stop->buses.erase(bus.name);
+        }
+        bus.stops.clear();
 
         for (const auto& stop : stopNames) {
             Stop* stopPtr = FindStop(stop);
             if (stopPtr) {
-                busPtr->stops.push_back(stopPtr);
-                stopPtr->buses.insert(busPtr->name);
+                bus.stops.push_back(stopPtr);
+                stopPtr->buses.insert(bus.name);
             }
         }
 
-        busPtr->originalStopCount = busPtr->stops.size();
+        if (bus.isRoundTrip && !bus.stops.empty() && bus.stops.front() != bus.stops.back()) {
+            bus.stops.push_back(bus.stops.front());
+        }
+    }
 
-        if (!is_roundtrip) {
-            for (int i = static_cast<int>(busPtr->stops.size()) - 2; i >= 0; --i) {
-                busPtr->stops.push_back(busPtr->stops[i]);
-            }
-        } else {
-            if (!busPtr->stops.empty() && busPtr->stops.front() != busPtr->stops.back()) {
-                busPtr->stops.push_back(busPtr->stops.front());
-            }
+    void TransportCatalogue::BulkLoad(CatalogueInput input) {
+        Unfreeze();
+        const size_t firstStop = stops_.size();
+        const size_t firstBus = buses_.size();
+
+        for (auto& stop : input.stops) {
+            stops_.push_back(Stop{std::move(stop.name), stop.coords, {}});
+        }
+        for (const auto& bus : input.buses) {
+            buses_.push_back(Bus{bus.name, {}, bus.isRoundTrip});
+        }
+
+        // Индексы по именам строятся одновременно: это независимые контейнеры
+        parallel::Invoke(
+            [&] {
+                stopsByName_.reserve(stops_.size());
+                for (size_t i = firstStop; i < stops_.size(); ++i) {
+                    stopsByName_[stops_[i].name] = &stops_[i];
+                }
+            },
+            [&] {
+                busesByName_.reserve(buses_.size());
+                for (size_t i = firstBus; i < buses_.size(); ++i) {
+                    busesByName_[buses_[i].name] = &buses_[i];
+                }
+            });
+
+        // Разрешение имён остановок только читает stopsByName_, каждый маршрут
+        // и каждое расстояние обрабатываются независимо
+        using StopPair = std::pair<const Stop*, const Stop*>;
+        std::vector<StopPair> distancePairs(input.distances.size());
+        parallel::Invoke(
+            [&] {
+                parallel::ForEachChunk(input.buses.size(), [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        Bus& bus = buses_[firstBus + i];
+                        bus.stops.reserve(input.buses[i].stops.size() + 1);
+                        for (const auto& stopName : input.buses[i].stops) {
+                            if (auto it = stopsByName_.find(stopName); it != stopsByName_.end()) {
+                                bus.stops.push_back(it->second);
+                            }
+                        }
+                        if (bus.isRoundTrip && !bus.stops.empty() && bus.stops.front() != bus.stops.back()) {
+                            bus.stops.push_back(bus.stops.front());
+                        }
+                    }
+                }, 64);
+            },
+            [&] {
+                parallel::ForEachChunk(input.distances.size(), [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        distancePairs[i] = {FindStop(input.distances[i].from), FindStop(input.distances[i].to)};
+                    }
+                });
+            });
+
+        // Хранилище расстояний заполняется одним потоком, а принадлежность
+        // маршрутов остановкам — параллельно, с разбиением остановок по хешу
+        const size_t partitions = parallel::GetThreadCount(buses_.size() - firstBus, 64);
+        parallel::Invoke(
+            [&] {
+                distances_.reserve(distances_.size() + distancePairs.size());
+                for (size_t i = 0; i < distancePairs.size(); ++i) {
+                    const auto& [from, to] = distancePairs[i];
+                    if (from && to && distances_.insert_or_assign({from, to}, input.distances[i].distance).second) {
+                        LinkDistance(from, to);
+                    }
+                }
+            },
+            [&] {
+                parallel::ForEachChunk(partitions, [&](size_t begin, size_t end) {
+                    for (size_t i = firstBus; i < buses_.size(); ++i) {
+                        for (Stop* stop : buses_[i].stops) {
+                            const size_t partition = std::hash<const Stop*>{}(stop) % partitions;
+                            if (partition >= begin && partition < end) {
+                                stop->buses.insert(buses_[i].name);
+                            }
+                        }
+                    }
+                }, 1);
+            });
+    }
+
+    void TransportCatalogue::Freeze() {
+        std::vector<std::pair<std::string_view, Stop*>> stops(stopsByName_.begin(), stopsByName_.end());
+        std::vector<std::pair<std::string_view, Bus*>> buses(busesByName_.begin(), busesByName_.end());
+        parallel::Invoke(
+            [&] { frozenStops_ = perfect_hash::PerfectHashIndex<Stop>(stops); },
+            [&] { frozenBuses_ = perfect_hash::PerfectHashIndex<Bus>(buses); },
+            [&] { nameIndex_ = BuildNameIndex(); },
+            [&] {
+                std::vector<const Bus*> liveBuses;
+                liveBuses.reserve(buses.size());
+                for (const auto& [_, bus] : buses) {
+                    liveBuses.push_back(bus);
+                }
+                std::vector<BusInfo> infos(liveBuses.size());
+                parallel::ForEachChunk(liveBuses.size(), [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        infos[i] = ComputeBusInfo(*liveBuses[i]);
+                    }
+                }, 256);
+                busInfo_.clear();
+                busInfo_.reserve(liveBuses.size());
+                for (size_t i = 0; i < liveBuses.size(); ++i) {
+                    busInfo_.emplace(liveBuses[i], infos[i]);
+                }
+            });
+        frozen_ = true;
+    }
+
+    void TransportCatalogue::Unfreeze() {
+        if (frozen_) {
+            frozenStops_ = {};
+            frozenBuses_ = {};
+            nameIndex_ = {};
+            busInfo_.clear();
+            frozen_ = false;
+        }
+    }
+
+    NameIndex TransportCatalogue::BuildNameIndex() const {
+        std::vector<std::pair<std::string_view, NameKind>> names;
+        names.reserve(stopsByName_.size() + busesByName_.size());
+        for (const auto& [name, _] : stopsByName_) {
+            names.emplace_back(name, NameKind::Stop);
+        }
+        for (const auto& [name, _] : busesByName_) {
+            names.emplace_back(name, NameKind::Bus);
         }
+        return NameIndex(names);
+    }
+
+    std::vector<NameSuggestion> TransportCatalogue::Suggest(std::string_view query, size_t count,
+                                                            std::optional<NameKind> kind) const {
+        if (frozen_) {
+            return nameIndex_.Suggest(query, count, kind);
+        }
+        return BuildNameIndex().Suggest(query, count, kind);
     }
 
     const Bus* TransportCatalogue::FindBus(const std::string_view& busName) const {
+        if (frozen_) {
+            return frozenBuses_.Find(busName);
+        }
         auto it = busesByName_.find(busName);
         return it != busesByName_.end() ? it->second : nullptr;
     }
 
     const Stop* TransportCatalogue::FindStop(const std::string_view& stopName) const {
+        if (frozen_) {
+            return frozenStops_.Find(stopName);
+        }
         auto it = stopsByName_.find(stopName);
         return it != stopsByName_.end() ? it->second : nullptr;
     }
 
     Stop* TransportCatalogue::FindStop(const std::string_view& stopName) {
+        if (frozen_) {
+            return frozenStops_.Find(stopName);
+        }
         auto it = stopsByName_.find(stopName);
         return it != stopsByName_.end() ? it->second : nullptr;
     }
 
     BusInfo TransportCatalogue::GetBusInfo(std::string_view& busName) const {
-        BusInfo info;
-
         const Bus* bus = FindBus(busName);
         if(!bus){
-            info.stopsCount = 0;
-            return info;
+            return BusInfo{};
         }
 
+        if (frozen_) {
+            if (auto it = busInfo_.find(bus); it != busInfo_.end()) {
+                return it->second;
+            }
+        }
+        return ComputeBusInfo(*bus);
+    }
+
+    BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) const {
+        BusInfo info;
+
         std::set<const Stop*> uniqueStops;
-        for(const auto& stop : bus->stops){
+        for(const auto& stop : bus.stops){
             uniqueStops.insert(stop);
         }
 
-        info.stopsCount = static_cast<int>(bus->stops.size());
+        info.stopsCount = static_cast<int>(bus.GetRouteStopCount());
         info.uniqueStops = static_cast<int>(uniqueStops.size());
-        info.routeLength = CalculateRouteLength(*bus);
-        info.geoDistance = CalculateGeoDistance(*bus);
+        info.routeLength = CalculateRouteLength(bus);
+        info.geoDistance = CalculateGeoDistance(bus);
         return info;
     }
 
@@ -83,7 +270,41 @@ namespace transport::catalogue {
     }
 
     void TransportCatalogue::SetDistanceBetweenStops(const Stop* from, const Stop* to,const double distance){
-        distances_[{from, to}] = distance;
+        if (distances_.insert_or_assign({from, to}, distance).second) {
+            LinkDistance(from, to);
+        }
+    }
+
+    void TransportCatalogue::LinkDistance(const Stop* from, const Stop* to) {
+        if (!hasDistanceNeighbours_) {
+            return;
+        }
+        distanceNeighbours_[from].push_back(to);
+        distanceNeighbours_[to].push_back(from);
+    }
+
+    void TransportCatalogue::UnlinkDistance(const Stop* from, const Stop* to) {
+        if (!hasDistanceNeighbours_) {
+            return;
+        }
+        // Пара в обе стороны даёт два вхождения, удаляется одно
+        auto unlink = [this](const Stop* stop, const Stop* neighbour) {
+            auto& neighbours = distanceNeighbours_[stop];
+            if (auto it = std::find(neighbours.begin(), neighbours.end(), neighbour); it != neighbours.end()) {
+                *it = neighbours.back();
+                neighbours.pop_back();
+            }
+        };
+        unlink(from, to);
+        unlink(to, from);
+    }
+
+    void TransportCatalogue::BuildDistanceNeighbours() {
+        hasDistanceNeighbours_ = true;
+        distanceNeighbours_.reserve(stops_.size());
+        for (const auto& [stops, _] : distances_) {
+            LinkDistance(stops.first, stops.second);
+        }
     }
 
     double TransportCatalogue::GetDistanceBetweenStops(const Stop* from, const Stop* to) const{
@@ -102,8 +323,12 @@ namespace transport::catalogue {
 
     double TransportCatalogue::CalculateRouteLength(const Bus& bus) const {
         double total_route_length = 0.0;
-        for (size_t i = 1; i < bus.stops.size(); ++i) {
-            total_route_length += GetDistanceBetweenStops(bus.stops[i - 1], bus.stops[i]);
+        const Stop* prev = nullptr;
+        for (const Stop* stop : bus.GetRouteStops()) {
+            if (prev) {
+                total_route_length += GetDistanceBetweenStops(prev, stop);
+            }
+            prev = stop;
         }
         return total_route_length;
     }
@@ -113,14 +338,357 @@ namespace transport::catalogue {
         for (size_t i = 1; i < bus.stops.size(); ++i) {
             geo_distance += ComputeDistance(bus.stops[i - 1]->coords, bus.stops[i]->coords);
         }
-        return geo_distance;
+        // Обратное направление некольцевого маршрута имеет ту же географическую длину
+        return bus.isRoundTrip ? geo_distance : geo_distance * 2;
     }
 
     std::vector<std::string> TransportCatalogue::GetBusNames() const {
         std::vector<std::string> bus_names;
-        for (const auto& bus : buses_) {
+        for (const auto& bus : GetBuses()) {
             bus_names.push_back(bus.name);
         }
         return bus_names;
     }
+
+    CatalogueChanges TransportCatalogue::ApplyDelta(const CatalogueDelta& delta) {
+        CatalogueChanges changes;
+
+        // Фиксированные индексы имён перестраиваются, только если меняется сам набор имён.
+        // Иначе достаточно пересчитать сведения о затронутых маршрутах
+        const bool wasFrozen = frozen_;
+        bool namesChanged = false;
+        for (const auto& stop : delta.stops) {
+            namesChanged = namesChanged || !stopsByName_.count(stop.name);
+        }
+        for (const auto& bus : delta.buses) {
+            namesChanged = namesChanged || !busesByName_.count(bus.name);
+        }
+        for (const auto& name : delta.removedStops) {
+            namesChanged = namesChanged || stopsByName_.count(name);
+        }
+        for (const auto& name : delta.removedBuses) {
+            namesChanged = namesChanged || busesByName_.count(name);
+        }
+        if (namesChanged) {
+            Unfreeze();
+        }
+
+        std::set<const Bus*> touchedBuses;
+        auto touchBusesOf = [this, &touchedBuses](const Stop& stop) {
+            for (const auto& busName : stop.buses) {
+                touchedBuses.insert(busesByName_.at(busName));
+            }
+        };
+        auto addUnique = [](std::vector<std::string>& names, const std::string& name) {
+            if (std::find(names.begin(), names.end(), name) == names.end()) {
+                names.push_back(name);
+            }
+        };
+
+        for (const auto& input : delta.stops) {
+            if (auto it = stopsByName_.find(input.name); it != stopsByName_.end()) {
+                Stop& stop = *it->second;
+                if (stop.coords.lat != input.coords.lat || stop.coords.lng != input.coords.lng) {
+                    stop.coords = input.coords;
+                    addUnique(changes.updatedStops, stop.name);
+                    touchBusesOf(stop);
+                }
+            } else {
+                stops_.push_back(Stop{input.name, input.coords, {}});
+                stopsByName_[stops_.back().name] = &stops_.back();
+                addUnique(changes.addedStops, input.name);
+            }
+        }
+
+        auto changeDistance = [&](const std::string& fromName, const std::string& toName, std::optional<double> distance) {
+            auto from = stopsByName_.find(fromName);
+            auto to = stopsByName_.find(toName);
+            if (from == stopsByName_.end() || to == stopsByName_.end()) {
+                return;
+            }
+            const std::pair<const Stop*, const Stop*> key{from->second, to->second};
+            auto it = distances_.find(key);
+            if (distance) {
+                if (it != distances_.end() && it->second == *distance) {
+                    return;
+                }
+                if (it != distances_.end()) {
+                    it->second = *distance;
+                } else {
+                    distances_.emplace(key, *distance);
+                    LinkDistance(key.first, key.second);
+                }
+            } else {
+                if (it == distances_.end()) {
+                    return;
+                }
+                distances_.erase(it);
+                UnlinkDistance(key.first, key.second);
+            }
+            changes.changedDistances.emplace_back(fromName, toName);
+            touchBusesOf(*from->second);
+            touchBusesOf(*to->second);
+        };
+        for (const auto& input : delta.distances) {
+            changeDistance(input.from, input.to, input.distance);
+        }
+        for (const auto& [from, to] : delta.removedDistances) {
+            changeDistance(from, to, std::nullopt);
+        }
+
+        for (const auto& input : delta.buses) {
+            if (auto it = busesByName_.find(input.name); it != busesByName_.end()) {
+                Bus& bus = *it->second;
+                Bus updated{bus.name, {}, input.isRoundTrip};
+                for (const auto& stopName : input.stops) {
+                    if (auto stop = stopsByName_.find(stopName); stop != stopsByName_.end()) {
+                        updated.stops.push_back(stop->second);
+                    }
+                }
+                if (updated.isRoundTrip && !updated.stops.empty() && updated.stops.front() != updated.stops.back()) {
+                    updated.stops.push_back(updated.stops.front());
+                }
+                if (updated.stops != bus.stops || updated.isRoundTrip != bus.isRoundTrip) {
+                    bus.isRoundTrip = input.isRoundTrip;
+                    SetBusStops(bus, input.stops);
+                    addUnique(changes.updatedBuses, bus.name);
+                    touchedBuses.insert(&bus);
+                }
+            } else {
+                buses_.push_back(Bus{input.name, {}, input.isRoundTrip});
+                Bus& bus = buses_.back();
+                busesByName_[bus.name] = &bus;
+                SetBusStops(bus, input.stops);
+                addUnique(changes.addedBuses, bus.name);
+                touchedBuses.insert(&bus);
+            }
+        }
+
+        for (const auto& name : delta.removedBuses) {
+            if (auto it = busesByName_.find(name); it != busesByName_.end()) {
+                Bus* bus = it->second;
+                touchedBuses.erase(bus);
+                RemoveBus(*bus);
+                addUnique(changes.removedBuses, name);
+            }
+        }
+
+        for (const auto& name : delta.removedStops) {
+            if (auto it = stopsByName_.find(name); it != stopsByName_.end()) {
+                std::set<const Bus*> routeChanged;
+                RemoveStop(*it->second, routeChanged);
+                for (const Bus* bus : routeChanged) {
+                    touchedBuses.insert(bus);
+                    if (std::find(changes.addedBuses.begin(), changes.addedBuses.end(), bus->name) == changes.addedBuses.end()) {
+                        addUnique(changes.updatedBuses, bus->name);
+                    }
+                }
+                addUnique(changes.removedStops, name);
+            }
+        }
+
+        changes.version = ++version_;
+
+        if (wasFrozen) {
+            if (namesChanged) {
+                Freeze();
+            } else {
+                for (const Bus* bus : touchedBuses) {
+                    busInfo_[bus] = ComputeBusInfo(*bus);
+                }
+            }
+        }
+        return changes;
+    }
+
+    void TransportCatalogue::RemoveBus(Bus& bus) {
+        for (Stop* stop : bus.stops) {
+            stop->buses.erase(bus.name);
+        }
+        if (auto it = busesByName_.find(bus.name); it != busesByName_.end() && it->second == &bus) {
+            busesByName_.erase(it);
+        }
+        bus.stops.clear();
+        bus.isRemoved = true;
+        ++removedBuses_;
+    }
+
+    void TransportCatalogue::RemoveStop(Stop& stop, std::set<const Bus*>& touchedBuses) {
+        // Остановка исключается из всех маршрутов, которые через неё проходят
+        for (const auto& busName : stop.buses) {
+            Bus& bus = *busesByName_.at(busName);
+            bus.stops.erase(std::remove(bus.stops.begin(), bus.stops.end(), &stop), bus.stops.end());
+            if (bus.isRoundTrip && !bus.stops.empty() && bus.stops.front() != bus.stops.back()) {
+                bus.stops.push_back(bus.stops.front());
+            }
+            touchedBuses.insert(&bus);
+        }
+        stop.buses.clear();
+
+        // Расстояния остановки находятся по её соседям, а не обходом всех пар
+        if (!hasDistanceNeighbours_) {
+            BuildDistanceNeighbours();
+        }
+        if (auto found = distanceNeighbours_.find(&stop); found != distanceNeighbours_.end()) {
+            for (const Stop* neighbour : found->second) {
+                distances_.erase({&stop, neighbour});
+                distances_.erase({neighbour, &stop});
+                if (neighbour != &stop) {
+                    auto& back = distanceNeighbours_[neighbour];
+                    back.erase(std::remove(back.begin(), back.end(), &stop), back.end());
+                }
+            }
+            distanceNeighbours_.erase(found);
+        }
+
+        if (auto it = stopsByName_.find(stop.name); it != stopsByName_.end() && it->second == &stop) {
+            stopsByName_.erase(it);
+        }
+        stop.isRemoved = true;
+        ++removedStops_;
+    }
+
+    NetworkStats TransportCatalogue::GetNetworkStats(size_t topCount) const {
+        std::vector<const Bus*> buses;
+        buses.reserve(GetBuses().size());
+        for (const Bus& bus : GetBuses()) {
+            buses.push_back(&bus);
+        }
+        std::vector<const Stop*> stops;
+        stops.reserve(GetStops().size());
+        for (const Stop& stop : GetStops()) {
+            stops.push_back(&stop);
+        }
+
+        using StopLoad = NetworkStats::StopLoad;
+        using BusStats = NetworkStats::BusStats;
+        auto busierStop = [](const StopLoad& lhs, const StopLoad& rhs) {
+            return lhs.busCount != rhs.busCount ? lhs.busCount > rhs.busCount : lhs.stop->name < rhs.stop->name;
+        };
+        // Каждая часть оставляет только свои topCount лучших остановок, свод повторяет отбор
+        auto keepBusiest = [&](std::vector<StopLoad>& loads) {
+            const size_t keep = std::min(topCount, loads.size());
+            std::partial_sort(loads.begin(), loads.begin() + keep, loads.end(), busierStop);
+            loads.resize(keep);
+        };
+
+        struct BusPartial {
+            double routeLength = 0.0;
+            double geoDistance = 0.0;
+            std::vector<BusStats> buses;
+        };
+        struct StopPartial {
+            size_t served = 0;
+            std::vector<StopLoad> busiest;
+        };
+
+        NetworkStats stats;
+        BusPartial busTotals;
+        StopPartial stopTotals;
+        parallel::Invoke(
+            [&] {
+                busTotals = parallel::ChunkedReduce(buses.size(), BusPartial{},
+                    [&](size_t begin, size_t end) {
+                        BusPartial partial;
+                        partial.buses.reserve(end - begin);
+                        for (size_t i = begin; i < end; ++i) {
+                            auto cached = frozen_ ? busInfo_.find(buses[i]) : busInfo_.end();
+                            BusInfo info = cached != busInfo_.end() ? cached->second : ComputeBusInfo(*buses[i]);
+                            partial.routeLength += info.routeLength;
+                            partial.geoDistance += info.geoDistance;
+                            partial.buses.push_back({buses[i], info});
+                        }
+                        return partial;
+                    },
+                    [](BusPartial& total, BusPartial&& partial) {
+                        total.routeLength += partial.routeLength;
+                        total.geoDistance += partial.geoDistance;
+                        total.buses.insert(total.buses.end(), partial.buses.begin(), partial.buses.end());
+                    }, 64);
+            },
+            [&] {
+                stopTotals = parallel::ChunkedReduce(stops.size(), StopPartial{},
+                    [&](size_t begin, size_t end) {
+                        StopPartial partial;
+                        for (size_t i = begin; i < end; ++i) {
+                            if (!stops[i]->buses.empty()) {
+                                ++partial.served;
+                                partial.busiest.push_back({stops[i], stops[i]->buses.size()});
+                            }
+                        }
+                        keepBusiest(partial.busiest);
+                        return partial;
+                    },
+                    [&](StopPartial& total, StopPartial&& partial) {
+                        total.served += partial.served;
+                        total.busiest.insert(total.busiest.end(), partial.busiest.begin(), partial.busiest.end());
+                        keepBusiest(total.busiest);
+                    });
+            });
+
+        stats.stopCount = stops.size();
+        stats.servedStopCount = stopTotals.served;
+        stats.busiestStops = std::move(stopTotals.busiest);
+        stats.busCount = buses.size();
+        stats.totalRouteLength = busTotals.routeLength;
+        stats.totalGeoDistance = busTotals.geoDistance;
+        stats.buses = std::move(busTotals.buses);
+        std::sort(stats.buses.begin(), stats.buses.end(), [](const BusStats& lhs, const BusStats& rhs) {
+            return lhs.bus->name < rhs.bus->name;
+        });
+
+        // Извилистость определена только для маршрутов ненулевой длины
+        for (const auto& bus : stats.buses) {
+            if (bus.info.geoDistance > 0) {
+                stats.mostCurvedBuses.push_back(bus);
+            }
+        }
+        auto curvature = [](const BusStats& bus) {
+            return bus.info.routeLength / bus.info.geoDistance;
+        };
+        const size_t keep = std::min(topCount, stats.mostCurvedBuses.size());
+        std::partial_sort(stats.mostCurvedBuses.begin(), stats.mostCurvedBuses.begin() + keep, stats.mostCurvedBuses.end(),
+            [&](const BusStats& lhs, const BusStats& rhs) {
+                return curvature(lhs) != curvature(rhs) ? curvature(lhs) > curvature(rhs) : lhs.bus->name < rhs.bus->name;
+            });
+        stats.mostCurvedBuses.resize(keep);
+        return stats;
+    }
+
+    void TransportCatalogue::CollectMemoryUsage(memory::MemoryReport& report) const {
+        // Удалённые дельтой объекты остаются в deque и тоже учитываются
+        memory::MemoryUsage stops = memory::ContainerUsage(stops_);
+        memory::MemoryUsage stopBuses;
+        for (const Stop& stop : stops_) {
+            stops += memory::ContainerUsage(stop.name);
+            stopBuses += memory::ContainerUsage(stop.buses);
+            for (const auto& busName : stop.buses) {
+                stopBuses += memory::ContainerUsage(busName);
+            }
+        }
+        memory::MemoryUsage buses = memory::ContainerUsage(buses_);
+        for (const Bus& bus : buses_) {
+            buses += memory::ContainerUsage(bus.name);
+            buses += memory::ContainerUsage(bus.stops);
+        }
+        memory::MemoryUsage frozenNames = frozenStops_.GetMemoryUsage();
+        frozenNames += frozenBuses_.GetMemoryUsage();
+
+        report.push_back({"catalogue.stops", stops});
+        report.push_back({"catalogue.stop_buses", stopBuses});
+        report.push_back({"catalogue.buses", buses});
+        report.push_back({"catalogue.stops_by_name", memory::ContainerUsage(stopsByName_)});
+        report.push_back({"catalogue.buses_by_name", memory::ContainerUsage(busesByName_)});
+        report.push_back({"catalogue.distances", memory::ContainerUsage(distances_)});
+        report.push_back({"catalogue.bus_info", memory::ContainerUsage(busInfo_)});
+        if (hasDistanceNeighbours_) {
+            memory::MemoryUsage neighbours = memory::ContainerUsage(distanceNeighbours_);
+            for (const auto& [_, list] : distanceNeighbours_) {
+                neighbours += memory::ContainerUsage(list);
+            }
+            report.push_back({"catalogue.distance_neighbours", neighbours});
+        }
+        report.push_back({"catalogue.frozen_names", frozenNames});
+        report.push_back({"catalogue.name_index", nameIndex_.GetMemoryUsage()});
+    }
 }
\ No newline at end of file
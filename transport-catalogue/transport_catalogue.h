@@ -2,7 +2,10 @@
 
 #include "geo.h"
 
+#include <cstdint>
 #include <deque>
+#include <iterator>
+#include <optional>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -10,13 +13,178 @@
 #include <set>
 
 #include "domain.h"
+#include "perfect_hash.h"
+#include "name_index.h"
+#include "memory_usage.h"
 
 namespace transport::catalogue {
 
+    // Описания объектов для пакетной загрузки справочника
+    struct StopInput {
+        std::string name;
+        geo::Coordinates coords;
+    };
+
+    struct DistanceInput {
+        std::string from;
+        std::string to;
+        double distance = 0.0;
+    };
+
+    struct BusInput {
+        std::string name;
+        std::vector<std::string> stops;
+        bool isRoundTrip = false;
+    };
+
+    struct CatalogueInput {
+        std::vector<StopInput> stops;
+        std::vector<DistanceInput> distances;
+        std::vector<BusInput> buses;
+    };
+
+    // Изменения справочника одной дельтой. Удаления применяются после добавлений
+    // и обновлений; обновление остановки или маршрута задаётся так же, как добавление
+    struct CatalogueDelta {
+        std::vector<StopInput> stops;
+        std::vector<std::string> removedStops;
+        std::vector<DistanceInput> distances;
+        std::vector<std::pair<std::string, std::string>> removedDistances;
+        std::vector<BusInput> buses;
+        std::vector<std::string> removedBuses;
+    };
+
+    // Точный перечень того, что изменила дельта, для инкрементального
+    // обновления производных структур (маршрутизатора, карты, индексов)
+    struct CatalogueChanges {
+        uint64_t version = 0;
+        std::vector<std::string> addedStops;
+        std::vector<std::string> updatedStops;
+        std::vector<std::string> removedStops;
+        std::vector<std::string> addedBuses;
+        std::vector<std::string> updatedBuses;
+        std::vector<std::string> removedBuses;
+        std::vector<std::pair<std::string, std::string>> changedDistances;
+
+        bool HasStopChanges() const {
+            return !addedStops.empty() || !updatedStops.empty() || !removedStops.empty();
+        }
+        bool HasBusChanges() const {
+            return !addedBuses.empty() || !updatedBuses.empty() || !removedBuses.empty();
+        }
+        bool IsEmpty() const {
+            return !HasStopChanges() && !HasBusChanges() && changedDistances.empty();
+        }
+    };
+
+    // Диапазон действующих объектов справочника: удалённые дельтой пропускаются
+    template <typename T>
+    class LiveObjects {
+    public:
+        using Container = std::deque<T>;
+
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            Iterator(typename Container::const_iterator it, typename Container::const_iterator end)
+                : it_(it), end_(end) {
+                SkipRemoved();
+            }
+
+            reference operator*() const {
+                return *it_;
+            }
+            pointer operator->() const {
+                return &*it_;
+            }
+            Iterator& operator++() {
+                ++it_;
+                SkipRemoved();
+                return *this;
+            }
+            bool operator==(const Iterator& rhs) const {
+                return it_ == rhs.it_;
+            }
+            bool operator!=(const Iterator& rhs) const {
+                return it_ != rhs.it_;
+            }
+
+        private:
+            void SkipRemoved() {
+                while (it_ != end_ && it_->isRemoved) {
+                    ++it_;
+                }
+            }
+
+            typename Container::const_iterator it_;
+            typename Container::const_iterator end_;
+        };
+
+        LiveObjects(const Container& items, size_t count)
+            : items_(&items), count_(count) {}
+
+        Iterator begin() const {
+            return Iterator(items_->begin(), items_->end());
+        }
+        Iterator end() const {
+            return Iterator(items_->end(), items_->end());
+        }
+        size_t size() const {
+            return count_;
+        }
+        bool empty() const {
+            return count_ == 0;
+        }
+
+    private:
+        const Container* items_;
+        size_t count_;
+    };
+
     class TransportCatalogue {
+        struct StopPairHash {
+            template <typename T, typename U>
+            std::size_t operator()(const std::pair<T, U>& p) const {
+                auto h1 = std::hash<T>{}(p.first);
+                auto h2 = std::hash<U>{}(p.second);
+                return h1 ^ h2;
+            }
+        };
+
     public:
+        using DistanceMap = std::unordered_map<std::pair<const Stop*, const Stop*>, double, StopPairHash>;
+
+        TransportCatalogue() = default;
+        // Глубокое копирование: указатели на остановки и маршруты перестраиваются
+        // на собственные данные копии. Используется для подготовки следующей версии справочника
+        TransportCatalogue(const TransportCatalogue& other);
+        // Перемещение оставляет остановки и маршруты на прежних адресах: deque передаёт
+        // свои блоки целиком, поэтому указатели на Stop и Bus остаются действительными
+        TransportCatalogue(TransportCatalogue&& other) = default;
+        TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+
         void AddStop(const std::string_view& name, const geo::Coordinates& coords);
         void AddBus(const std::string_view& name, const std::vector<std::string>& stopNames, const bool is_roundtrip = false);
+        // Загружает все остановки, расстояния и маршруты за один раз. Индексы строятся
+        // с заранее зарезервированной ёмкостью, разрешение имён идёт в несколько потоков
+        void BulkLoad(CatalogueInput input);
+        // Фиксирует набор имён после загрузки: FindStop и FindBus переходят на
+        // минимальные совершенные хеш-таблицы. Любое добавление снимает фиксацию
+        void Freeze();
+        bool IsFrozen() const { return frozen_; }
+        // Применяет дельту к действующему справочнику, увеличивает номер версии
+        // и возвращает перечень изменений
+        CatalogueChanges ApplyDelta(const CatalogueDelta& delta);
+        uint64_t GetVersion() const { return version_; }
+        // Подсказки по префиксу названия остановки или маршрута с учётом опечаток.
+        // Индекс строится при фиксации, без неё собирается на время запроса
+        std::vector<NameSuggestion> Suggest(std::string_view query, size_t count,
+                                            std::optional<NameKind> kind = std::nullopt) const;
         const Bus* FindBus(const std::string_view& busName) const;
         const Stop* FindStop(const std::string_view& stopName) const;
         Stop* FindStop(const std::string_view& stopName);
@@ -24,24 +192,46 @@ namespace transport::catalogue {
         const std::set<std::string>& GetBusesByStop(std::string_view stopName) const;
         void SetDistanceBetweenStops(const Stop* from, const Stop* to, const double distance);
         double GetDistanceBetweenStops(const Stop* from, const Stop* to) const;
-        const std::deque<Bus>& GetBuses() const { return buses_; }
+        LiveObjects<Bus> GetBuses() const { return {buses_, buses_.size() - removedBuses_}; }
+        LiveObjects<Stop> GetStops() const { return {stops_, stops_.size() - removedStops_}; }
+        const DistanceMap& GetDistances() const { return distances_; }
         std::vector<std::string> GetBusNames() const;
+        // Сводка по всей сети за один параллельный проход по маршрутам и остановкам.
+        // topCount ограничивает списки самых загруженных остановок и извилистых маршрутов
+        NetworkStats GetNetworkStats(size_t topCount) const;
+        // Оценка памяти по контейнерам справочника
+        void CollectMemoryUsage(memory::MemoryReport& report) const;
 
     private:
-        struct StopPairHash {
-            template <typename T, typename U>
-            std::size_t operator()(const std::pair<T, U>& p) const {
-                auto h1 = std::hash<T>{}(p.first);
-                auto h2 = std::hash<U>{}(p.second);
-                return h1 ^ h2;
-            }
-        };
-
         std::deque<Stop> stops_;
         std::deque<Bus> buses_;
         std::unordered_map<std::string_view, Stop*> stopsByName_;
         std::unordered_map<std::string_view, Bus*> busesByName_;
-        std::unordered_map<std::pair<const Stop*, const Stop*>, double, StopPairHash> distances_;
+        DistanceMap distances_;
+        perfect_hash::PerfectHashIndex<Stop> frozenStops_;
+        perfect_hash::PerfectHashIndex<Bus> frozenBuses_;
+        NameIndex nameIndex_;
+        std::unordered_map<const Bus*, BusInfo> busInfo_;
+        // Соседи по расстояниям: для остановки — другие концы её записей в distances_
+        // в обе стороны. Строится при первом удалении остановки и дальше поддерживается,
+        // чтобы удаление не обходило все расстояния справочника
+        std::unordered_map<const Stop*, std::vector<const Stop*>> distanceNeighbours_;
+        bool hasDistanceNeighbours_ = false;
+        bool frozen_ = false;
+        size_t removedStops_ = 0;
+        size_t removedBuses_ = 0;
+        uint64_t version_ = 0;
+
+        void Unfreeze();
+        NameIndex BuildNameIndex() const;
+        BusInfo ComputeBusInfo(const Bus& bus) const;
+        void SetBusStops(Bus& bus, const std::vector<std::string>& stopNames);
+        void RemoveBus(Bus& bus);
+        void RemoveStop(Stop& stop, std::set<const Bus*>& touchedBuses);
+        // Запись в distances_ добавлена или удалена; до построения соседей ничего не делают
+        void LinkDistance(const Stop* from, const Stop* to);
+        void UnlinkDistance(const Stop* from, const Stop* to);
+        void BuildDistanceNeighbours();
 
         double CalculateRouteLength(const Bus& bus) const;
         double CalculateGeoDistance(const Bus& bus) const;
@@ -10,7 +10,14 @@ constexpr double METERS_IN_KM = 1000.0;
 constexpr double MINUTES_IN_HOUR = 60.0;
 
 TransportRouter::TransportRouter(const TransportCatalogue& db, RoutingSettings settings)
-    : db_(db), settings_(settings)
+    : db_(&db), settings_(settings)
+{
+    BuildGraph();
+    router_ = std::make_unique<graph::Router<double>>(graph_);
+}
+
+TransportRouter::TransportRouter(CatalogueSnapshots::Snapshot snapshot, RoutingSettings settings)
+    : snapshot_(std::move(snapshot)), db_(&*snapshot_), settings_(settings)
 {
     BuildGraph();
     router_ = std::make_unique<graph::Router<double>>(graph_);
@@ -28,7 +35,7 @@ void TransportRouter::BuildGraph() {
 
 std::unordered_set<const Stop*> TransportRouter::CollectUniqueStops() {
     std::unordered_set<const Stop*> result;
-    for (const auto& bus : db_.GetBuses()) {
+    for (const auto& bus : db_->GetBuses()) {
         for (const Stop* stop : bus.stops) {
             result.insert(stop);
         }
@@ -37,59 +44,137 @@ std::unordered_set<const Stop*> TransportRouter::CollectUniqueStops() {
 }
 
 void TransportRouter::InitVerticesAndWaitEdges(const std::unordered_set<const Stop*>& unique_stops) {
-    graph_ = graph::DirectedWeightedGraph<double>(unique_stops.size() * 2);
-    graph::VertexId vid = 0;
-
+    graph_ = graph::DirectedWeightedGraph<double>();
     for (const Stop* stop : unique_stops) {
-        const graph::VertexId wait_id = vid++;
-        const graph::VertexId board_id = vid++;
-
-        stop_to_wait_id_[stop] = wait_id;
-        stop_to_board_id_[stop] = board_id;
-
-        graph::Edge<double> wait_edge{
-            wait_id,
-            board_id,
-            static_cast<double>(settings_.bus_wait_time)
-        };
-        edge_items_.push_back(RouteItem{RouteItem::Type::Wait, stop->name, 0, settings_.bus_wait_time});
-        graph_.AddEdge(wait_edge);
+        AddStopVertices(stop);
     }
 }
 
+void TransportRouter::AddStopVertices(const Stop* stop) {
+    const graph::VertexId wait_id = graph_.AddVertex();
+    const graph::VertexId board_id = graph_.AddVertex();
+
+    stop_to_wait_id_[stop] = wait_id;
+    stop_to_board_id_[stop] = board_id;
+
+    graph::Edge<double> wait_edge{
+        wait_id,
+        board_id,
+        static_cast<double>(settings_.bus_wait_time)
+    };
+    edge_items_.push_back(RouteItem{RouteItem::Type::Wait, stop->name, 0, settings_.bus_wait_time});
+    graph_.AddEdge(wait_edge);
+}
+
 void TransportRouter::AddBusEdges() {
-    for (const auto& bus : db_.GetBuses()) {
-        const auto& stops = bus.stops;
-        if (stops.empty()) continue;
-        
-        for (size_t i = 0; i < stops.size(); ++i) {
-            double total_distance = 0.0;
-            for (size_t j = i + 1; j < stops.size(); ++j) {
-                const Stop* from = stops[i];
-                const Stop* to = stops[j];
-                if (!from || !to) continue;
-
-                auto from_board_it = stop_to_board_id_.find(from);
-                auto to_wait_it = stop_to_wait_id_.find(to);
-                if (from_board_it == stop_to_board_id_.end() || to_wait_it == stop_to_wait_id_.end()) continue;
-
-                total_distance += db_.GetDistanceBetweenStops(stops[j - 1], stops[j]);
-                double time = ComputeTravelTime(total_distance);
-                graph::Edge<double> edge{
-                    from_board_it->second,
-                    to_wait_it->second,
-                    time
-                };
-                edge_items_.push_back(RouteItem{RouteItem::Type::Bus, bus.name, static_cast<int>(j - i), time});
-                graph_.AddEdge(edge);
+    for (const auto& bus : db_->GetBuses()) {
+        AddBusEdges(bus);
+    }
+}
+
+void TransportRouter::AddBusEdges(const Bus& bus) {
+    const size_t stop_count = bus.GetRouteStopCount();
+    if (stop_count == 0) return;
+
+    for (size_t i = 0; i < stop_count; ++i) {
+        double total_distance = 0.0;
+        const Stop* from = bus.GetRouteStop(i);
+        for (size_t j = i + 1; j < stop_count; ++j) {
+            const Stop* to = bus.GetRouteStop(j);
+            if (!from || !to) continue;
+
+            auto from_board_it = stop_to_board_id_.find(from);
+            auto to_wait_it = stop_to_wait_id_.find(to);
+            if (from_board_it == stop_to_board_id_.end() || to_wait_it == stop_to_wait_id_.end()) continue;
+
+            total_distance += db_->GetDistanceBetweenStops(bus.GetRouteStop(j - 1), to);
+            double time = ComputeTravelTime(total_distance);
+            graph::Edge<double> edge{
+                from_board_it->second,
+                to_wait_it->second,
+                time
+            };
+            edge_items_.push_back(RouteItem{RouteItem::Type::Bus, bus.name, static_cast<int>(j - i), time});
+            graph_.AddEdge(edge);
+        }
+    }
+}
+
+bool TransportRouter::IsAffectedBy(const CatalogueChanges& changes) const {
+    return changes.HasBusChanges() || ChangesGraphDistances(changes);
+}
+
+bool TransportRouter::ApplyChanges(const CatalogueChanges& changes) {
+    if (!changes.updatedBuses.empty() || !changes.removedBuses.empty() || ChangesGraphDistances(changes)) {
+        return false;
+    }
+    // Новые маршруты только добавляют вершины и рёбра, старые рёбра остаются верными
+    const graph::EdgeId first_edge = graph_.GetEdgeCount();
+    for (const auto& name : changes.addedBuses) {
+        const Bus* bus = db_->FindBus(name);
+        if (!bus) continue;
+        for (const Stop* stop : bus->stops) {
+            if (stop && !stop_to_wait_id_.count(stop)) {
+                AddStopVertices(stop);
             }
         }
+        AddBusEdges(*bus);
+    }
+    router_->AddEdges(first_edge);
+    return true;
+}
+
+bool TransportRouter::Rebind(CatalogueSnapshots::Snapshot snapshot) {
+    const TransportCatalogue& db = *snapshot;
+    std::unordered_map<const Stop*, graph::VertexId> stop_to_wait_id;
+    std::unordered_map<const Stop*, graph::VertexId> stop_to_board_id;
+    stop_to_wait_id.reserve(stop_to_wait_id_.size());
+    stop_to_board_id.reserve(stop_to_board_id_.size());
+    for (const auto& [stop, wait_id] : stop_to_wait_id_) {
+        const Stop* rebound = db.FindStop(stop->name);
+        if (!rebound) {
+            return false;
+        }
+        stop_to_wait_id.emplace(rebound, wait_id);
+        stop_to_board_id.emplace(rebound, stop_to_board_id_.at(stop));
+    }
+    stop_to_wait_id_ = std::move(stop_to_wait_id);
+    stop_to_board_id_ = std::move(stop_to_board_id);
+    // Прежняя версия отпускается только после переноса: имена читались из неё
+    snapshot_ = std::move(snapshot);
+    db_ = &*snapshot_;
+    return true;
+}
+
+bool TransportRouter::ChangesGraphDistances(const CatalogueChanges& changes) const {
+    for (const auto& [from, to] : changes.changedDistances) {
+        const Stop* from_stop = db_->FindStop(from);
+        const Stop* to_stop = db_->FindStop(to);
+        if (stop_to_wait_id_.count(from_stop) && stop_to_wait_id_.count(to_stop)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TransportRouter::CollectMemoryUsage(memory::MemoryReport& report) const {
+    graph_.CollectMemoryUsage(report, "router.graph.");
+    report.push_back({"router.routes", router_->GetMemoryUsage()});
+
+    memory::MemoryUsage items = memory::ContainerUsage(edge_items_);
+    for (const auto& item : edge_items_) {
+        items += memory::ContainerUsage(item.name);
     }
+    report.push_back({"router.edge_items", items});
+
+    memory::MemoryUsage vertices = memory::ContainerUsage(stop_to_wait_id_);
+    vertices += memory::ContainerUsage(stop_to_board_id_);
+    report.push_back({"router.stop_vertices", vertices});
 }
 
 std::optional<std::vector<RouteItem>> TransportRouter::BuildRoute(std::string_view from, std::string_view to) const {
-    const Stop* from_stop = db_.FindStop(from);
-    const Stop* to_stop = db_.FindStop(to);
+    const Stop* from_stop = db_->FindStop(from);
+    const Stop* to_stop = db_->FindStop(to);
     if (!from_stop || !to_stop) return std::nullopt;
 
     auto from_it = stop_to_wait_id_.find(from_stop);
@@ -3,6 +3,7 @@
 #include "graph.h"
 #include "router.h"
 #include "transport_catalogue.h"
+#include "catalogue_snapshot.h"
 #include <memory>
 #include <string_view>
 #include <unordered_map>
@@ -27,17 +28,34 @@ struct RouteItem {
 class TransportRouter {
 public:
     TransportRouter(const catalogue::TransportCatalogue& db, RoutingSettings settings);
+    // Маршрутизатор удерживает закреплённую версию справочника, пока существует сам
+    TransportRouter(catalogue::CatalogueSnapshots::Snapshot snapshot, RoutingSettings settings);
 
     std::optional<std::vector<RouteItem>> BuildRoute(std::string_view from, std::string_view to) const;
+    // Нужно ли перестраивать граф после дельты. Координаты остановок и остановки
+    // вне маршрутов на граф не влияют
+    bool IsAffectedBy(const catalogue::CatalogueChanges& changes) const;
+    // Дополняет граф и таблицу путей маршрутами, добавленными дельтой. Возвращает
+    // false, если дельта меняет или удаляет рёбра графа: тогда граф строится заново
+    bool ApplyChanges(const catalogue::CatalogueChanges& changes);
+    // Переводит граф на другую версию справочника: вершины переносятся по именам
+    // остановок, таблица путей не пересчитывается. Возвращает false, если какой-то
+    // остановки графа в версии нет; маршрутизатор тогда нужно построить заново
+    bool Rebind(catalogue::CatalogueSnapshots::Snapshot snapshot);
+    void CollectMemoryUsage(memory::MemoryReport& report) const;
 
 private:
     void BuildGraph();
     double ComputeTravelTime(double distance_meters) const;
     std::unordered_set<const transport::catalogue::Stop*> CollectUniqueStops();
     void InitVerticesAndWaitEdges(const std::unordered_set<const transport::catalogue::Stop*>& unique_stops);
+    void AddStopVertices(const catalogue::Stop* stop);
     void AddBusEdges();
+    void AddBusEdges(const catalogue::Bus& bus);
+    bool ChangesGraphDistances(const catalogue::CatalogueChanges& changes) const;
 
-    const catalogue::TransportCatalogue& db_;
+    catalogue::CatalogueSnapshots::Snapshot snapshot_;
+    const catalogue::TransportCatalogue* db_;
     RoutingSettings settings_;
     graph::DirectedWeightedGraph<double> graph_;
     std::unique_ptr<graph::Router<double>> router_;